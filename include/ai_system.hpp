@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.hpp"
+#include "frame_arena.hpp"
 #include "render_system.hpp"
 #include "tinyECS/registry.hpp"
 #include "pathing.hpp"
@@ -12,6 +13,7 @@ class AISystem {
 
    private: 
     uint get_distance(Node node1, Node node2);
-    std::vector<ivec2> get_walkable_neighbours(Node node);
-    std::vector<ivec2> retrace_path(std::vector<Node> visited_nodes, Node start_node, Node exit_node);
+    // the search's scratch lives in the frame arena
+    void get_walkable_neighbours(Node node, FrameVector<ivec2>& neighbours);
+    std::vector<ivec2> retrace_path(const FrameVector<Node>& visited_nodes, Node start_node, Node exit_node);
 };
@@ -0,0 +1,34 @@
+#pragma once
+
+// stlib
+#include <cstdint>
+
+// Running totals of every heap allocation in the process, counted by the global operator new / delete
+// replacements in alloc_tracking.cpp. Take the difference of two snapshots to get the allocations in between.
+struct AllocationTotals {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;  // requested by operator new, frees are not subtracted
+};
+
+AllocationTotals allocationTotals();
+
+// Allocations are also counted per zone, the zone being whatever the allocating thread is inside of.
+// Zone 0 is everything outside a zone; system_timings.hpp numbers the rest.
+const int allocation_zone_count = 16;
+
+AllocationTotals allocationTotals(int zone);
+int currentAllocationZone();
+
+// Attributes this thread's allocations to a zone until the end of the scope
+class ScopedAllocationZone {
+   public:
+    explicit ScopedAllocationZone(int zone);
+    ~ScopedAllocationZone();
+
+    ScopedAllocationZone(const ScopedAllocationZone&) = delete;
+    ScopedAllocationZone& operator=(const ScopedAllocationZone&) = delete;
+
+   private:
+    int previous;
+};
@@ -73,6 +73,16 @@ public:
         return this->text;
     }
 
+    bool hasText() const {
+        return !this->text.empty();
+    }
+
+    // Changes whenever the text does and is never shared by two elements,
+    // so the renderer can key cached text layouts on it.
+    unsigned int getTextRevision() const {
+        return this->text_revision;
+    }
+
     const float getFontSize() {
         return this->font_size;
     }
@@ -88,6 +98,9 @@ protected:
     // Used for UI's that need text rendering.
     float font_size;
     std::string text;
+    unsigned int text_revision = ++next_text_revision;
+
+    inline static unsigned int next_text_revision = 0;
 };
 
 // This is just a wrapper for a list of UI Elements.
@@ -98,6 +111,14 @@ public:
     bool remove(int idx);
     int size();
     std::vector<std::shared_ptr<Element>> getElems();
+    // Same as getElems, into a vector of the caller's, e.g. a FrameVector so that it does not allocate
+    template <typename Vector>
+    void collectElems(Vector& elems) const {
+        elems.clear();
+        elems.insert(elems.end(), ui_elems.begin(), ui_elems.end());
+        elems.insert(elems.end(), inventory_ui_elems.begin(), inventory_ui_elems.end());
+        elems.insert(elems.end(), gacha_ui_elems.begin(), gacha_ui_elems.end());
+    }
     std::shared_ptr<Element> getPauseUI();
 
     void update(float dt);
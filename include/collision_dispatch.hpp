@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/tiny_ecs.hpp"
+#include "tinyECS/components.hpp"
+#include "contact_cache.hpp"
+
+// stlib
+#include <array>
+#include <functional>
+#include <vector>
+
+// An entity only ever belongs to one category, checked in COLLISION_CATEGORY order
+COLLISION_CATEGORY getCollisionCategory(Entity entity);
+
+// Called with the entities in the same order as the categories it was registered with.
+// Return false to stop handling the remaining collisions of this step (e.g. the player died).
+using CollisionHandler = std::function<bool(Entity, Entity, const Collision&)>;
+
+// Called on contact transitions from the ContactCache, entities ordered like CollisionHandler.
+// On EXIT either entity may already have been removed.
+using ContactHandler = std::function<void(CONTACT_EVENT, Entity, Entity, const Contact&)>;
+
+// Collision responses keyed on a pair of categories. Pairs are stored in canonical
+// (lower category first) order, so each handler is written once for either record order.
+class CollisionDispatcher {
+   public:
+    void registerHandler(COLLISION_CATEGORY a, COLLISION_CATEGORY b, CollisionHandler handler);
+    // exit_grace_ms: how long the pair must be apart before EXIT, see ContactCache::setExitGrace
+    void registerContactHandler(COLLISION_CATEGORY a,
+                                COLLISION_CATEGORY b,
+                                ContactHandler handler,
+                                float exit_grace_ms = CONTACT_EXIT_GRACE_MS);
+
+    // Handles the pending contact transitions, then handles and clears registry.collisions.
+    // Returns false if a handler stopped the step.
+    bool dispatch();
+
+   private:
+    struct HandlerSlot {
+        CollisionHandler handler;
+        bool swapped = false;  // handler was registered as (higher, lower)
+    };
+
+    struct ContactHandlerSlot {
+        ContactHandler handler;
+        bool swapped = false;
+    };
+
+    struct PendingCollision {
+        Entity first;
+        Entity second;
+        vec2 normal;
+        unsigned int lo;
+        unsigned int hi;
+    };
+
+    std::array<HandlerSlot, collision_category_count * collision_category_count> handlers;
+    std::array<ContactHandlerSlot, collision_category_count * collision_category_count> contact_handlers;
+    std::vector<PendingCollision> pending;
+};
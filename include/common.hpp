@@ -143,6 +143,38 @@ const float HEAL_COOLDOWN = 10000.0f;  // 10 second
 const float HEAL_AMOUNT = 25.0f;
 
 const float BUNNY_BASE_DROPOFF_TIME = 1000.0f;  // ship must be in base for 1 second before the bunnies get dropped off
+// Circle pairs tested per block while the pair list fills. Polygon pairs per worker task, and at most
+// this many threads besides the main one
+const size_t NARROWPHASE_CIRCLE_BLOCK = 256;
+const size_t NARROWPHASE_POLY_TASK_SIZE = 2;
+const unsigned int PHYSICS_MAX_WORKER_THREADS = 3;
+// A contact must be apart this long before it exits, unless its contact handler sets its own grace
+const float CONTACT_EXIT_GRACE_MS = 500.0f;
+// Sprites the batch vertex buffer holds before it has to grow
+const size_t SPRITE_BATCH_INITIAL_CAPACITY = 1024;
+// Sprites up to this size in texels are packed into square atlas pages at startup
+const int TEXTURE_ATLAS_SIZE = 1024;
+const int TEXTURE_ATLAS_MAX_SPRITE_SIZE = 256;
+const int TEXTURE_ATLAS_PADDING = 1;
+// Glyphs are baked once at this size as distance fields and scaled to every font size.
+// A spread of 0 rasterizes a plain coverage atlas at the default font size instead.
+const int FONT_SDF_BAKE_SIZE = 48;
+const int FONT_SDF_SPREAD = 6;
+// Particles the instance ring buffer holds before it has to grow
+const size_t PARTICLE_BUFFER_INITIAL_CAPACITY = 4096;
+// Entities and particles whose bounds lie further than this outside the window are not drawn
+const float VIEW_CULL_MARGIN_PX = 32.0f;
+// Frames the statistics keep for percentiles and export, one minute at 60 FPS
+const size_t FRAME_STATS_HISTORY = 3600;
+// Frames in the performance HUD's graph, and how often its numbers change
+const size_t PERF_HUD_GRAPH_FRAMES = 120;
+const float PERF_HUD_TEXT_REFRESH_MS = 250.0f;
+// Query sets the GPU pass timer cycles through, the times it reports are this many frames minus one old
+const size_t GPU_TIMER_FRAMES = 2;
+// Ticks after a level loads before bnuuy_sim --alloc-budget starts checking, pools and caches fill up first
+const int ALLOC_BUDGET_WARMUP_TICKS = 120;
+// Bytes in each thread's frame arena (see frame_arena.hpp), beyond it allocations fall back to the heap
+const size_t FRAME_ARENA_BYTES = 1 << 20;
 
 const float DEFAULT_PARTICLE_TIME = 50.0f;
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/tiny_ecs.hpp"
+#include "tinyECS/components.hpp"
+
+// stlib
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+enum class CONTACT_EVENT {
+    ENTER = 0,
+    STAY = ENTER + 1,
+    EXIT = STAY + 1,
+};
+
+// A pair of entities that are touching, remembered across physics steps
+struct Contact {
+    Entity a;  // lower entity id of the pair
+    Entity b;
+    COLLISION_CATEGORY category_a;
+    COLLISION_CATEGORY category_b;
+    vec2 mtv = {0, 0};
+    vec2 prev_mtv = {0, 0};    // MTV of the previous step, used to warm start the next SAT test
+    float duration_ms = 0;     // how long the pair has been touching
+    float missing_ms = 0;      // how long since the pair was last reported
+    unsigned int last_step = 0;
+};
+
+struct ContactEvent {
+    CONTACT_EVENT type;
+    Contact contact;
+};
+
+// Remembers which pairs collided in the previous steps so gameplay can react to
+// enter / stay / exit transitions instead of re-deriving them every frame.
+class ContactCache {
+   public:
+    static ContactCache& getInstance();
+
+    // Refresh the cache from this step's registry.collisions and queue the transitions
+    void update(float elapsed_ms);
+
+    // nullptr when the pair is not in contact
+    const Contact* find(Entity e1, Entity e2) const;
+
+    const std::vector<ContactEvent>& getEvents() const { return events; }
+    void clearEvents() { events.clear(); }
+
+    // How long a pair of these categories must be apart before it exits, CONTACT_EXIT_GRACE_MS unless set
+    void setExitGrace(COLLISION_CATEGORY a, COLLISION_CATEGORY b, float ms);
+
+    // drop every contact without emitting EXIT, e.g. when a level is unloaded
+    void clear();
+
+   private:
+    ContactCache() { exit_grace_ms.fill(CONTACT_EXIT_GRACE_MS); }
+    ContactCache(const ContactCache&) = delete;
+    ContactCache& operator=(const ContactCache&) = delete;
+
+    static uint64_t key(Entity e1, Entity e2);
+    float exitGraceMs(const Contact& contact) const;
+
+    std::unordered_map<uint64_t, Contact> contacts;
+    std::vector<ContactEvent> events;
+    std::vector<uint64_t> expired;
+    unsigned int step_count = 0;
+    // indexed like the dispatcher's handlers, lower category first
+    std::array<float, collision_category_count * collision_category_count> exit_grace_ms;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Metrics of one glyph, in pixels of the size the atlas was baked at
+struct FontGlyph {
+    vec4 uv_rect = {0.f, 0.f, 0.f, 0.f};  // (u0, v0, u1, v1), covers the distance field spread
+    vec2 size = {0.f, 0.f};               // quad size, spread included
+    vec2 bearing = {0.f, 0.f};            // from the pen position on the baseline to the quad's top-left
+    float advance = 0.f;
+};
+
+// First 128 ASCII glyphs packed into a single square one-byte-per-texel page
+struct FontAtlas {
+    int bake_size = 0;
+    int spread = 0;  // distance field range in texels, 0 for a plain coverage atlas
+    int size = 0;
+    std::array<FontGlyph, 128> glyphs;
+    std::vector<uint8_t> pixels;
+};
+
+// Rasterizes the font with FreeType at bake_size. With spread > 0 every glyph is stored as a
+// signed distance field (0.5 on the outline, 0 and 1 at spread texels outside and inside).
+bool bakeFontAtlas(const std::string& font_filename, int bake_size, int spread, FontAtlas& atlas);
+
+// Coverage (size.x * size.y) to a distance field of (size + 2 * spread), thresholded at half coverage
+void computeSignedDistanceField(const uint8_t* coverage, ivec2 size, int spread, std::vector<uint8_t>& field);
+
+// The cache is rejected if it was baked with other parameters or from a font file of another size
+bool loadFontAtlasCache(const std::string& cache_filename,
+                        const std::string& font_filename,
+                        int bake_size,
+                        int spread,
+                        FontAtlas& atlas);
+bool saveFontAtlasCache(const std::string& cache_filename, const std::string& font_filename, const FontAtlas& atlas);
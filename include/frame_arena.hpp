@@ -0,0 +1,78 @@
+#pragma once
+
+// stlib
+#include <cstddef>
+#include <vector>
+
+// Freed arena memory is overwritten unless NDEBUG is set; BNUUY_ARENA_POISON keeps it in release builds too
+#if !defined(NDEBUG) || defined(BNUUY_ARENA_POISON)
+#define BNUUY_ARENA_POISON_ENABLED 1
+#endif
+
+// Bump allocator for data that does not outlive the frame. Allocating moves an offset, deallocating only
+// gives back the most recent allocation (last-in first-out frees) and reset() hands the whole block out
+// again. Requests that do not fit go to operator new, so running out is slow but never fatal. Every thread
+// has its own arenas and endFrame() resets them.
+class FrameArena {
+   public:
+    explicit FrameArena(size_t capacity);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void deallocate(void* pointer, size_t bytes);
+    void reset();
+
+    size_t used() const { return offset; }
+    size_t capacity() const { return size; }
+    size_t highWater() const { return high_water; }
+
+    // The calling thread's arena, emptied when the frame ends
+    static FrameArena& frame();
+    // The calling thread's half of a pair that alternates every frame: what is allocated during one
+    // frame stays valid until the end of the next, e.g. for the render after the following update
+    static FrameArena& doubleBuffered();
+    // Resets every thread's frame arena and the older half of every pair. The main loop calls it
+    // between frames, when no other thread can be holding arena memory.
+    static void endFrame();
+
+   private:
+    bool owns(const void* pointer) const;
+
+    char* memory = nullptr;  // allocated on first use, so an arena a thread never touches costs nothing
+    size_t size;
+    size_t offset = 0;
+    size_t high_water = 0;
+    bool warned = false;  // about falling back to the heap, once per arena
+};
+
+// STL allocator on a FrameArena, this thread's frame arena unless told otherwise
+template <typename T>
+class FrameAllocator {
+   public:
+    using value_type = T;
+
+    FrameAllocator() : arena(&FrameArena::frame()) {}
+    explicit FrameAllocator(FrameArena& arena) : arena(&arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T* pointer, size_t count) { arena->deallocate(pointer, count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,94 @@
+#pragma once
+
+// stlib
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "alloc_tracking.hpp"
+#include "gpu_timer.hpp"
+#include "system_timings.hpp"
+
+// Everything measured about one frame of the main loop
+struct FrameSample {
+    uint64_t frame = 0;
+    float frame_ms = 0.f;   // the whole loop iteration, buffer swap included
+    float update_ms = 0.f;  // scene switch, scene update and world step
+    float render_ms = 0.f;  // RenderSystem::draw on the CPU
+    std::array<float, sim_system_count> system_ms = {};  // the level's systems, zero outside of levels
+    float gpu_ms = 0.f;  // draw() on the GPU, GPU_TIMER_FRAMES - 1 frames old, zero without a timer
+    std::array<float, gpu_pass_count> gpu_pass_ms = {};
+    int draw_calls = 0;
+    int sprites = 0;
+    int gl_calls_issued = 0;
+    int gl_calls_elided = 0;
+    // allocations, filled in by FrameStats::endFrame
+    uint32_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    std::array<uint32_t, sim_system_count> system_allocations = {};
+    std::array<uint64_t, sim_system_count> system_allocated_bytes = {};
+    uint32_t render_allocations = 0;
+    uint64_t render_allocated_bytes = 0;
+};
+
+struct FrameTimeSummary {
+    float p50 = 0.f;
+    float p95 = 0.f;
+    float p99 = 0.f;
+    float max = 0.f;
+};
+
+// Keeps the last FRAME_STATS_HISTORY frames for rolling percentiles, and writes them out per frame as
+// CSV or JSON. Entity counts are taken per registry container when a frame ends.
+class FrameStats {
+   public:
+    static FrameStats& getInstance();
+
+    // Adds the frame, with the allocations made since the previous endFrame, in total and per zone
+    void endFrame(FrameSample sample);
+
+    // Frames currently in the window, at most FRAME_STATS_HISTORY
+    size_t size() const { return count; }
+    // age 0 is the latest frame
+    const FrameSample& frame(size_t age) const { return samples[slot(age)]; }
+    uint32_t entityCount(size_t age, size_t container) const {
+        return entity_counts[slot(age) * container_count + container];
+    }
+
+    // Percentiles over the window of any float field, e.g. summarize(&FrameSample::frame_ms)
+    FrameTimeSummary summarize(float FrameSample::*metric) const;
+    FrameTimeSummary summarizeSystem(SIM_SYSTEM system) const;
+    FrameTimeSummary summarizeGpuPass(GPU_PASS pass) const;
+
+    // Writes every frame in the window, JSON when the path ends in .json and CSV otherwise
+    bool exportFile(const std::string& path) const;
+    bool exportCSV(const std::string& path) const;
+    bool exportJSON(const std::string& path) const;
+
+    // Where exports go when no path is given, e.g. from the debug key
+    void setExportPath(const std::string& path) { export_path = path; }
+    const std::string& getExportPath() const { return export_path; }
+
+    FrameStats(const FrameStats&) = delete;
+    FrameStats& operator=(const FrameStats&) = delete;
+
+   private:
+    FrameStats();
+
+    size_t slot(size_t age) const { return (next + samples.size() - 1 - age) % samples.size(); }
+    FrameTimeSummary summarizeScratch() const;
+
+    std::vector<FrameSample> samples;
+    std::vector<uint32_t> entity_counts;  // container_count per frame, same slots as samples
+    size_t container_count = 0;
+    size_t next = 0;
+    size_t count = 0;
+    uint64_t frames_recorded = 0;
+    AllocationTotals last_allocations;
+    std::array<AllocationTotals, allocation_zone_count> last_zone_allocations;
+    std::string export_path = "frame_stats.csv";
+
+    // reused by summarize so percentiles do not allocate
+    mutable std::vector<float> scratch;
+};
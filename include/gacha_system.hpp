@@ -29,7 +29,6 @@ private:
 
     std::vector<std::unordered_set<MODULE_TYPES>> levelModulePools;
     std::unordered_map<MODULE_TYPES, float> moduleDropRates;
-    std::default_random_engine rng;
 
     // Scuffed implementation but ig it's fine.
     std::vector<bool> hovered_options = {false, false, false};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+// Remembers the bindings made through it and skips the GL call when nothing would change.
+// Element array bindings are part of the VAO, so they are not tracked. Code that binds
+// behind the tracker's back must call invalidate() before using it again.
+class GLStateTracker {
+   public:
+    GLStateTracker() { invalidate(); }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindArrayBuffer(GLuint buffer);
+    void activeTexture(GLenum unit);
+    // binds to the active texture unit
+    void bindTexture2D(GLuint texture);
+    // texture must be the one bound to the active unit
+    void texParameter(GLuint texture, GLenum pname, GLint value);
+
+    // Forget the bindings, the next call of each kind is always issued. Texture parameters are
+    // object state and stay remembered, set them through the tracker only.
+    void invalidate();
+
+    void resetCounters();
+    int issuedCalls() const { return issued; }
+    int elidedCalls() const { return elided; }
+
+   private:
+    static const GLuint UNKNOWN = ~0u;
+    static const int TRACKED_TEXTURE_UNITS = 8;
+
+    bool changed(GLuint& current, GLuint value);
+
+    GLuint program = UNKNOWN;
+    GLuint vao = UNKNOWN;
+    GLuint array_buffer = UNKNOWN;
+    GLuint active_unit = UNKNOWN;
+    std::array<GLuint, TRACKED_TEXTURE_UNITS> textures;
+    // (texture << 32 | pname) -> value
+    std::unordered_map<uint64_t, GLint> tex_parameters;
+
+    int issued = 0;
+    int elided = 0;
+};
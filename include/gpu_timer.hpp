@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <array>
+
+// Passes of RenderSystem::draw timed on the GPU, in the order they are drawn
+enum class GPU_PASS {
+    CLEAR = 0,
+    SPRITES = CLEAR + 1,      // the sorted render commands, whirlpools and the rest of the world
+    PARTICLES = SPRITES + 1,
+    TORNADOES = PARTICLES + 1,
+    UI = TORNADOES + 1,
+    OVERLAY = UI + 1,
+    UI_OVER_OVERLAY = OVERLAY + 1,
+    PLAYER = UI_OVER_OVERLAY + 1,
+    PERF_HUD = PLAYER + 1,
+    PRESENT = PERF_HUD + 1,  // drawToScreen's vignette blit
+    GPU_PASS_COUNT = PRESENT + 1
+};
+const int gpu_pass_count = (int) GPU_PASS::GPU_PASS_COUNT;
+
+const std::array<const char*, gpu_pass_count> gpu_pass_names = {
+    "clear", "sprites", "particles", "tornadoes", "ui", "overlay", "ui_top", "player", "hud", "present"};
+
+// GPU time per pass from GL_TIMESTAMP queries at every pass boundary. Each frame writes one of
+// GPU_TIMER_FRAMES query sets in turn, and a set is read back just before it is reused, and only
+// once the GPU is done with it, so timing never stalls the CPU. The times trail the frame being
+// drawn by GPU_TIMER_FRAMES - 1 frames.
+class GpuPassTimer {
+   public:
+    // After the context exists; stays disabled when the context has no timestamp counter
+    void init();
+    void destroy();
+    bool isEnabled() const { return enabled; }
+
+    // Picks up the oldest set's results if they are ready, then stamps the start of the frame
+    void beginFrame();
+    // Every pass must be ended every frame, in order, even when it drew nothing
+    void endPass(GPU_PASS pass);
+    void endFrame();
+
+    // The latest complete results, zero until the first set has been read
+    const std::array<float, gpu_pass_count>& getPassMs() const { return pass_ms; }
+    float getTotalMs() const { return total_ms; }
+
+   private:
+    bool enabled = false;
+    std::array<std::array<GLuint, gpu_pass_count + 1>, GPU_TIMER_FRAMES> queries = {};
+    std::array<bool, GPU_TIMER_FRAMES> in_flight = {};
+    size_t current = 0;
+
+    std::array<float, gpu_pass_count> pass_ms = {};
+    float total_ms = 0.f;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class WorldSystem;
+
+// One input callback, as WorldSystem received it
+enum class INPUT_EVENT_TYPE : uint8_t { KEY = 0, MOUSE_MOVE = 1, MOUSE_BUTTON = 2 };
+
+struct InputEvent {
+    INPUT_EVENT_TYPE type = INPUT_EVENT_TYPE::KEY;
+    int key_or_button = 0;
+    int action = 0;
+    int mods = 0;
+    vec2 position = {0.f, 0.f};  // unscaled cursor position, as GLFW reports it
+};
+
+// Log layout, native byte order:
+//   header  "BREC", u32 version, u32 seed
+//   ticks   f32 elapsed_ms, u16 event count, events
+//   events  u8 type, then KEY / MOUSE_BUTTON: i16 key or button, u8 action, u8 mods
+//                         MOUSE_MOVE:         f32 x, f32 y
+// A log replays in the executable that recorded it, from the same starting scene.
+class InputRecorder {
+   public:
+    bool open(const std::string& path, uint32_t seed);
+    void close();
+    bool isOpen() const { return file.is_open(); }
+
+    // Buffered until the tick they were delivered in ends
+    void record(const InputEvent& event);
+    void endTick(float elapsed_ms);
+
+    unsigned int tickCount() const { return ticks; }
+
+   private:
+    std::ofstream file;
+    std::vector<InputEvent> tick_events;
+    unsigned int ticks = 0;
+};
+
+class InputReplay {
+   public:
+    bool open(const std::string& path);
+    uint32_t getSeed() const { return seed; }
+
+    // Feeds the next tick's events through the WorldSystem input callbacks and returns its elapsed time.
+    // False once the log is exhausted.
+    bool nextTick(WorldSystem& world_system, float& elapsed_ms);
+
+    unsigned int tickCount() const { return ticks; }
+
+   private:
+    std::ifstream file;
+    uint32_t seed = 0;
+    unsigned int ticks = 0;
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "common.hpp"
+#include "tinyECS/tiny_ecs.hpp"
+#include "tinyECS/components.hpp"
+
+// stlib
+#include <cstddef>
+
+// position += velocity * step_seconds for n bodies, 8 (AVX) or 4 (SSE) at a time when available
+void integrateSoA(float* x, float* y, const float* vx, const float* vy, size_t n, float step_seconds);
+
+// Branch-free integration of every Motion in place, done before any per-entity gameplay logic
+void integrateMotions(ComponentContainer<Motion>& motions, float step_seconds);
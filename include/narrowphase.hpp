@@ -0,0 +1,38 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <cstdint>
+#include <vector>
+
+// Candidate pairs for the bounding-circle test, one SoA lane per pair.
+// A pair hits when the centres are closer than the larger of the two radii.
+struct CirclePairs {
+    std::vector<uint32_t> first;   // indices into registry.motions
+    std::vector<uint32_t> second;
+    std::vector<float> ax, ay;
+    std::vector<float> bx, by;
+    std::vector<float> a_r_squared;
+    std::vector<float> b_r_squared;
+
+    void clear();
+    size_t size() const { return first.size(); }
+    void push(uint32_t i, uint32_t j, vec2 a, float a_r_sq, vec2 b, float b_r_sq);
+};
+
+// Candidate pairs for the axis-aligned box test, one SoA lane per pair
+struct BoxPairs {
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    std::vector<float> ax, ay, a_half_w, a_half_h;
+    std::vector<float> bx, by, b_half_w, b_half_h;
+
+    void clear();
+    size_t size() const { return first.size(); }
+    void push(uint32_t i, uint32_t j, vec2 a, vec2 a_half, vec2 b, vec2 b_half);
+};
+
+// Test pairs [begin, end) 8 (AVX) or 4 (SSE) at a time and append the indices of the hits, in order
+void narrowphaseCircles(const CirclePairs& pairs, size_t begin, size_t end, std::vector<uint32_t>& hits);
+void narrowphaseBoxes(const BoxPairs& pairs, size_t begin, size_t end, std::vector<uint32_t>& hits);
@@ -1,7 +1,8 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
 #include "common.hpp"
+#include "rng.hpp"
 #include "tinyECS/tiny_ecs.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
@@ -9,12 +10,17 @@
 class ParticleSystem {
 public:
     void step(float elapsed_ms);
-    void Emit(ParticleEmitter& emitter, float dt);
+    // random holds PARTICLE_RANDOMS_PER_EMIT uniform [0, 1) values
+    void Emit(ParticleEmitter& emitter, const float* random);
 
     ParticleSystem();
 
 private:
-    std::random_device rd;
-    std::mt19937 generator;
-    std::uniform_real_distribution<float> float_distribution;
+    static const int PARTICLE_RANDOMS_PER_EMIT = 4;
+    static const int PARTICLES_PER_BURST = 5;
+
+    Pcg32& random_stream;
 };
+
+// values[i] += delta for n values, 8 (AVX) or 4 (SSE) at a time when available
+void addToAll(float* values, size_t n, float delta);
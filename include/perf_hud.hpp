@@ -0,0 +1,57 @@
+#pragma once
+
+// stlib
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bnuui/buttons.hpp"
+#include "system_timings.hpp"
+
+struct FrameSample;
+
+// Debug overlay drawn over everything else (F3 toggles it). Shows the frame time graph, per-system bars,
+// GPU pass times, draw and GL state counts, live entity counts and particle / projectile totals from
+// FrameStats.
+class PerfHud {
+   public:
+    static PerfHud& getInstance();
+
+    void toggle() { visible = !visible; }
+    bool isVisible() const { return visible; }
+
+    // Refreshes the elements from the frames recorded so far, call it after FrameStats::endFrame
+    void update(float elapsed_ms);
+
+    // The panel, graph and bars, then every text label
+    const std::vector<std::shared_ptr<bnuui::Element>>& getElems() const { return elems; }
+
+    PerfHud(const PerfHud&) = delete;
+    PerfHud& operator=(const PerfHud&) = delete;
+
+   private:
+    PerfHud();
+
+    std::shared_ptr<bnuui::TextLabel> addLabel(vec2 position);
+    void updateGraph();
+    void updateText();
+    void updateGpuText(const FrameSample& latest);
+    // Fills the labels line by line with as many entries as fit
+    void wrapText(const std::vector<std::string>& entries,
+                  const std::vector<std::shared_ptr<bnuui::TextLabel>>& labels);
+
+    bool visible = false;
+    float text_timer_ms = 0.f;
+
+    std::vector<std::shared_ptr<bnuui::Element>> elems;
+    std::vector<std::shared_ptr<bnuui::SimpleBox>> graph_bars;
+    std::array<std::shared_ptr<bnuui::SimpleBox>, sim_system_count> system_bars;
+    std::array<std::shared_ptr<bnuui::TextLabel>, sim_system_count> system_labels;  // average ms, the names are static
+    std::shared_ptr<bnuui::TextLabel> frame_label;
+    std::shared_ptr<bnuui::TextLabel> percentile_label;
+    std::vector<std::shared_ptr<bnuui::TextLabel>> gpu_labels;
+    std::shared_ptr<bnuui::TextLabel> draw_label;
+    std::shared_ptr<bnuui::TextLabel> totals_label;
+    std::vector<std::shared_ptr<bnuui::TextLabel>> entity_labels;
+};
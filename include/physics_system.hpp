@@ -4,6 +4,8 @@
 #include "tinyECS/tiny_ecs.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
+#include "motion_integration.hpp"
+#include "narrowphase.hpp"
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem {
@@ -12,4 +14,45 @@ class PhysicsSystem {
     static bool collidesPolyVec(Entity island_entity, ivec2 node_pos);
 
     PhysicsSystem() {}
+
+   private:
+    enum BODY_FLAGS { BODY_ISLAND = 1, BODY_BASE = 2, BODY_SHIP = 4 };
+
+    // all reused every step so they do not reallocate
+    std::vector<uint8_t> body_flags;
+    std::vector<vec2> body_half_extents;
+    std::vector<float> body_r_squared;
+    CirclePairs circle_pairs;
+    BoxPairs box_pairs;
+    std::vector<uint32_t> narrowphase_hits;
+
+    // a ship vs island / base pair that passed the box test, resolved for the workers
+    struct PolyPair {
+        uint32_t first;
+        uint32_t second;
+        const std::vector<tson::Vector2i>* polygon;
+        const Motion* entity_motion;  // the island or base
+        const Motion* ship_motion;
+        bool check_inside;  // base: ship must be fully inside
+        vec2 warm_axis;
+    };
+    std::vector<PolyPair> poly_pairs;
+
+    struct NarrowphaseHit {
+        uint32_t first;  // indices into registry.motions
+        uint32_t second;
+        vec2 mtv;
+    };
+    std::vector<NarrowphaseHit> circle_hits;
+    // only ever touched by the thread running that task
+    struct NarrowphaseTask {
+        std::vector<NarrowphaseHit> hits;
+    };
+    std::vector<NarrowphaseTask> narrowphase_tasks;
+
+    struct MergedHit {
+        uint64_t key;  // entity pair
+        NarrowphaseHit hit;
+    };
+    std::vector<MergedHit> merged_hits;
 };
@@ -0,0 +1,70 @@
+#pragma once
+
+// stlib
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Zones are compiled in unless NDEBUG is set; BNUUY_PROFILE keeps them in release builds too
+#if !defined(NDEBUG) || defined(BNUUY_PROFILE)
+#define BNUUY_PROFILE_ENABLED 1
+#endif
+
+// Scoped CPU zones written as Chrome trace_event JSON (chrome://tracing or ui.perfetto.dev).
+// Every thread appends to its own fixed-size buffer, so recording a zone takes no lock.
+class Profiler {
+   public:
+    // Clears the buffers and starts recording zones on every thread
+    static void start();
+    static void stop();
+    static bool isCapturing() { return capturing.load(std::memory_order_relaxed); }
+
+    // Stops the capture and writes everything recorded since start()
+    static bool writeChromeTrace(const std::string& path);
+
+    // Label for the calling thread's track in the trace
+    static void nameThread(const char* name);
+
+    // Nanoseconds on the steady clock
+    static uint64_t now();
+    // name must outlive the capture, zones use string literals
+    static void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+   private:
+    inline static std::atomic<bool> capturing{false};
+};
+
+class ProfileZone {
+   public:
+    explicit ProfileZone(const char* name) : name(Profiler::isCapturing() ? name : nullptr) {
+        if (this->name) start_ns = Profiler::now();
+    }
+    ~ProfileZone() { end(); }
+
+    // Closes the zone before the end of the scope
+    void end() {
+        if (name) Profiler::record(name, start_ns, Profiler::now());
+        name = nullptr;
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+   private:
+    const char* name;
+    uint64_t start_ns = 0;
+};
+
+#ifdef BNUUY_PROFILE_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing scope
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+// A zone that can be closed early with PROFILE_ZONE_END, for spans that do not match a scope
+#define PROFILE_ZONE_NAMED(var, name) ProfileZone var(name)
+#define PROFILE_ZONE_END(var) var.end()
+#else
+#define PROFILE_ZONE(name) ((void) 0)
+#define PROFILE_ZONE_NAMED(var, name) ((void) 0)
+#define PROFILE_ZONE_END(var) ((void) 0)
+#endif
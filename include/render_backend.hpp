@@ -0,0 +1,36 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How the renderer reaches the GPU
+enum class RENDER_BACKEND {
+    WINDOW = 0,    // GLFW window, the default
+    HEADLESS = 1,  // offscreen GL 3.3 core context through EGL, no display needed (Mesa llvmpipe works)
+    NULL_GL = 2,   // no GL at all, every call the renderer makes is recorded and dropped
+};
+
+// Accepts "window", "headless" or "null"
+bool parseRenderBackend(const std::string& name, RENDER_BACKEND& backend);
+
+// Creates an offscreen context, makes it current and loads the GL entry points.
+// Only available on builds with EGL (HAVE_EGL), returns false otherwise.
+bool createHeadlessContext();
+void destroyHeadlessContext();
+
+// Points the gl3w entry points the renderer uses at stubs that only record the call.
+// Object names come from a counter and queries report success, so the renderer's
+// asserts on locations, compile and link status and framebuffer completeness pass.
+void installNullGL();
+// Calls recorded since the last clear, in issue order
+const std::vector<const char*>& nullGLCommands();
+void clearNullGLCommands();
+
+// Reads back the bound read framebuffer as RGBA8 and writes it top row first
+bool writeFramebufferPNG(const std::string& path, int width, int height);
+// Stored (uncompressed) deflate, which is all golden-image diffs need
+bool writePNG(const std::string& path, const uint8_t* rgba, int width, int height);
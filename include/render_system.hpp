@@ -1,9 +1,13 @@
 #pragma once
 #include <array>
+#include <unordered_map>
 #include <utility>
 
 #include "bnuui/bnuui.hpp"
 #include "common.hpp"
+#include "gl_state.hpp"
+#include "gpu_timer.hpp"
+#include "render_backend.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/tiny_ecs.hpp"
 
@@ -18,13 +22,113 @@
 
 // fonts
 struct Character {
-	unsigned int TextureID;  // ID handle of the glyph texture
-	glm::ivec2   Size;       // Size of glyph
-	glm::ivec2   Bearing;    // Offset from baseline to left/top of glyph
-	unsigned int Advance;    // Offset to advance to next glyph
+	vec4         UVRect;     // (u0, v0, u1, v1) of the glyph in the font atlas
+	vec2         Size;       // Size of glyph quad, in pixels of the default font size
+	vec2         Bearing;    // Offset from baseline to left/top of glyph quad
+	float        Advance;    // Offset to advance to next glyph, in pixels
 	char character;
 };
 
+// Vertex of the text batch, in the font projection's screen space
+struct TextVertex {
+    vec2 position;
+    vec2 texcoord;
+    vec3 color;
+};
+
+// Glyph quads of one text element, laid out again only when what it shows changes
+struct TextLayout {
+    unsigned int text_revision = 0;
+    vec2 position = {0.f, 0.f};
+    float scale = 0.f;
+    vec3 color = {0.f, 0.f, 0.f};
+    unsigned int version = 0;  // unique across layouts, new on every rebuild
+    unsigned int last_frame = 0;
+    std::vector<TextVertex> vertices;
+};
+
+// Text drawn at one flush point, its buffer is uploaded only when the queued layouts change
+struct TextBatch {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    size_t capacity = 0;  // bytes
+    std::vector<const TextLayout*> queued;
+    std::vector<unsigned int> queued_versions;
+    std::vector<unsigned int> uploaded_versions;
+    GLsizei uploaded_vertex_count = 0;
+};
+
+// Per-instance data of the sprite pipeline, the vertex shader builds the
+// translate * scale * rotate matrix from the first three fields
+struct SpriteInstance {
+    vec2 position;
+    vec2 scale;
+    float angle;           // degrees, as in Motion
+    uint16_t uv_rect[4];   // normalized (u0, v0, u1, v1)
+    uint8_t tint[4];       // normalized rgba
+};
+static_assert(sizeof(SpriteInstance) == 32, "sprite instances are uploaded as 32 byte records");
+
+// Per-instance data of the particle pipeline, the vertex shader places the quad from position,
+// size and rotation the same way as translate * rotate * scale
+struct ParticleInstance {
+    vec2 position;
+    float size;       // quad edge in pixels
+    float rotation;   // radians
+    vec4 color;
+};
+static_assert(sizeof(ParticleInstance) == 32, "particle instances are uploaded as 32 byte records");
+
+// One per render request drawn in the world pass, sorted on key:
+// layer (8 bits) | effect (8) | GL texture (16) | submission order (32)
+struct RenderCommand {
+    uint64_t key;
+    Entity entity;
+};
+
+// Consecutive instances drawn with one call, or a single command the sprite pipeline cannot handle
+struct SpriteRun {
+    size_t first_sprite;
+    size_t sprite_count;
+    GLuint texture;  // GL name, sprites from the same atlas page share a run
+    Entity entity;
+    bool batched;
+};
+
+// Locations of one effect, looked up once in initializeGlEffects. -1 where the effect does not use them.
+struct EffectPipeline {
+    GLuint program = 0;
+    GLint in_position = -1;
+    GLint in_texcoord = -1;
+    GLint in_color = -1;
+    GLint transform = -1;
+    GLint projection = -1;
+    GLint fcolor = -1;
+    GLint uv_rect = -1;
+    // transparent
+    GLint alpha = -1;
+    GLint visible = -1;
+    GLint num_centers = -1;
+    GLint centers = -1;
+    // vignette
+    GLint time = -1;
+    GLint darken_screen_factor = -1;
+};
+
+// Counters for the last frame, reset at the start of draw()
+struct RenderStats {
+    int draw_calls = 0;
+    int sprites = 0;       // render requests drawn as sprite instances
+    int sprite_runs = 0;   // draw calls those sprites were merged into
+    float cpu_ms = 0.f;    // time spent in draw() before swapping buffers
+    int gl_calls_issued = 0;   // state changes that went through the GLStateTracker
+    int gl_calls_elided = 0;   // state changes it skipped as redundant
+    int draws_submitted = 0;   // world entities that passed the view cull
+    int draws_culled = 0;      // world entities skipped because they were off-screen
+    int particles_drawn = 0;
+    int particles_culled = 0;
+};
+
 // System responsible for setting up OpenGL and for rendering all the
 // visual entities in the game
 class RenderSystem {
@@ -37,21 +141,46 @@ class RenderSystem {
      */
     std::array<GLuint, texture_count> texture_gl_handles;
     std::array<ivec2, texture_count> texture_dimensions;
+    // (u0, v0, u1, v1) of each asset inside its GL texture, atlas pages are shared by many assets
+    std::array<vec4, texture_count> texture_uv_rects;
+    std::vector<GLuint> texture_atlas_pages;
 
 	GLuint m_VAO;
 
 	// fonts
-	std::map<char, Character> m_ftCharacters;
+	// first 128 ASCII chars, indexed by the char itself
+	std::array<Character, 128> m_ftCharacters = {};
+	EFFECT_ASSET_ID m_font_effect = EFFECT_ASSET_ID::FONT;
 	GLuint m_font_shaderProgram;
-	GLuint m_font_VAO;
-	GLuint m_font_VBO;
+	GLuint m_font_atlas = 0;
+	// cached layouts of the text elements drawn last frame
+	std::unordered_map<const bnuui::Element*, TextLayout> text_layouts;
+	// one batch per flushText call in draw()
+	std::array<TextBatch, 3> text_batches;
+	size_t text_batch_index = 0;
+	unsigned int text_frame = 0;
+	unsigned int next_text_layout_version = 0;
+	std::vector<TextVertex> text_vertices;
 
     // Particles
     GLuint m_QuadVAO;
 	GLuint m_Particle_shaderProgram;
 	GLint m_ParticleShaderViewProj;
-    GLuint m_InstanceTransformVBO;
-    GLuint m_InstanceColorVBO;
+    // ring of ParticleInstance, every frame's particles are written after the previous frame's
+    GLuint m_particle_instance_VBO;
+    size_t particle_buffer_capacity = 0;  // instances
+    size_t particle_ring_offset = 0;      // first free instance
+    std::vector<ParticleInstance> particle_instances;
+
+    // Instanced sprites, the SPRITE geometry drawn once per SpriteInstance in a streaming buffer
+    GLuint m_sprite_batch_VAO;
+    GLuint m_sprite_instance_VBO;
+    size_t sprite_batch_capacity = 0;
+    std::vector<SpriteInstance> sprite_instances;
+    std::vector<RenderCommand> render_commands;
+    std::vector<SpriteRun> sprite_runs;
+
+    RenderStats frame_stats;
 
     // Overlay highlights
     std::array<vec3, 5> highlight_centers;
@@ -294,6 +423,7 @@ class RenderSystem {
     };
 
     std::array<GLuint, effect_count> effects;
+    std::array<EffectPipeline, effect_count> pipelines;
     // Make sure these paths remain in sync with the associated enumerators.
     const std::array<std::string, effect_count> effect_paths = {
         shader_path("coloured"), 
@@ -304,20 +434,32 @@ class RenderSystem {
         shader_path("font"),
         shader_path("particle"),
         shader_path("transparent"),
+        shader_path("sprite_batch"),
+        shader_path("font_sdf"),
     };
 
     std::array<GLuint, geometry_count> vertex_buffers;
     std::array<GLuint, geometry_count> index_buffers;
     std::array<Mesh, geometry_count> meshes;
+    // filled in by bindVBOandIBO
+    std::array<GLsizei, geometry_count> index_counts = {};
+    std::array<GLsizei, geometry_count> vertex_strides = {};
+    // one VAO per (effect, geometry), created the first time the pair is drawn
+    std::array<GLuint, effect_count * geometry_count> geometry_vaos = {};
+
+    GLStateTracker gl_state;
+    GpuPassTimer gpu_timer;
 
    public:
-    // Initialize the window
-    bool init(GLFWwindow* window);
+    // Initialize the window, window is null for the headless and null backends
+    bool init(GLFWwindow* window, RENDER_BACKEND backend = RENDER_BACKEND::WINDOW);
 
 	bool fontInit(const std::string& font_filename, unsigned int font_default_size);
 
     bool particleSystemInit();
 
+    bool spriteBatchInit();
+
     template <class T>
     void bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices, std::vector<uint16_t> indices);
 
@@ -353,10 +495,32 @@ class RenderSystem {
     mat3 createProjectionMatrix();
     mat4 createUIMatrix();
 
-    void renderText(std::string text, float x, float y, float scale, const glm::vec3& color, const glm::mat4& trans);
+    // Appends the glyph quads of text, y up from the bottom of the window
+    void layoutText(const std::string& text,
+                    float x,
+                    float y,
+                    float scale,
+                    const glm::vec3& color,
+                    const glm::mat4& trans,
+                    std::vector<TextVertex>& vertices);
+    // Queues the element's text, laying it out only if it changed since it was last drawn
+    void renderText(bnuui::Element& element);
+    // Draws all queued text with one call
+    void flushText();
+    // Drops the layouts of elements that were not drawn this frame
+    void endTextFrame();
 
     Entity get_screen_state_entity() { return screen_state_entity; } 
 
+    const RenderStats& getFrameStats() const { return frame_stats; }
+    const GpuPassTimer& getGpuTimer() const { return gpu_timer; }
+
+    RENDER_BACKEND getBackend() const { return backend; }
+    // Size of what drawToScreen renders into, the window's framebuffer or the offscreen one
+    ivec2 getFramebufferSize() const;
+    // Writes the next presented frame to a PNG, read back just before the swap
+    void requestFrameDump(const std::string& path) { frame_dump_path = path; }
+
    private:
     // Internal drawing functions for each entity type
     void drawGridLine(Entity entity, const mat3& projection);
@@ -366,20 +530,37 @@ class RenderSystem {
     // Drawing function for UI elements
     void drawUIElement(bnuui::Element& element, const mat3& projection);
 
-    // Instance rendering for particle emitters.
-    void drawParticles(Entity entity, const mat3& projection);
+    // Instance rendering for particle emitters, all emitters share one draw
+    void drawParticles(const mat3& projection);
   
     // draw highlight square for modules
     void drawSquareOutline(vec2 position, vec2 size, vec3 color, const mat3& projection);
 
     void drawOverlay(Entity entity, const mat3& projection);
 
+    // Binds the effect and the VAO of the geometry in its vertex layout, returns the cached locations
+    const EffectPipeline& usePipeline(EFFECT_ASSET_ID effect, GEOMETRY_BUFFER_ID geometry);
+    GLuint geometryVAO(EFFECT_ASSET_ID effect, GEOMETRY_BUFFER_ID geometry);
+    // Binds to unit 0 with nearest filtering
+    void bindSpriteTexture(GLuint texture);
+
+    // Sorted render commands, batching textured sprites that share a texture
+    void drawRenderCommands(const mat3& projection);
+    void pushSprite(Entity entity, const vec4& uv_rect);
+    void growSpriteBatch(size_t sprite_count);
+    void drawSpriteRun(const SpriteRun& run, const mat3& projection);
+
 
     // Window handle
     GLFWwindow* window;
+    RENDER_BACKEND backend = RENDER_BACKEND::WINDOW;
+    std::string frame_dump_path;
 
     // Screen texture handles
     GLuint frame_buffer;
+    // stands in for the default framebuffer when there is no window
+    GLuint screen_frame_buffer = 0;
+    GLuint screen_render_buffer_color = 0;
     GLuint off_screen_render_buffer_color;
     GLuint off_screen_render_buffer_depth;
 
@@ -0,0 +1,99 @@
+#pragma once
+
+// stlib
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// PCG32 (XSH RR), 8 bytes of state plus the stream selector and a few ns per number.
+// Also a UniformRandomBitGenerator, so it plugs into the <random> distributions.
+class Pcg32 {
+   public:
+    using result_type = uint32_t;
+
+    Pcg32() { seed(0, 0); }
+    Pcg32(uint64_t seed_value, uint64_t stream) { seed(seed_value, stream); }
+
+    // Generators with the same seed but different streams produce unrelated sequences
+    void seed(uint64_t seed_value, uint64_t stream) {
+        state = 0;
+        increment = (stream << 1u) | 1u;
+        next();
+        state += seed_value;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old_state = state;
+        state = old_state * 6364136223846793005ull + increment;
+        uint32_t xorshifted = (uint32_t) (((old_state >> 18u) ^ old_state) >> 27u);
+        uint32_t rotation = (uint32_t) (old_state >> 59u);
+        return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+    }
+
+    // Uniform in [0, 1), the top 24 bits fill a float mantissa exactly
+    float nextFloat() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+    // Uniform in [0, bound) without modulo bias (Lemire)
+    uint32_t nextBelow(uint32_t bound) {
+        uint64_t product = (uint64_t) next() * bound;
+        uint32_t low = (uint32_t) product;
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                product = (uint64_t) next() * bound;
+                low = (uint32_t) product;
+            }
+        }
+        return (uint32_t) (product >> 32);
+    }
+
+    // Uniform in [min, max]
+    int nextInt(int min, int max) { return min + (int) nextBelow((uint32_t) (max - min) + 1u); }
+
+    // n uniform [0, 1) floats, for callers that want a batch per step
+    void fillFloats(float* values, size_t n) {
+        for (size_t i = 0; i < n; i++) values[i] = nextFloat();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+    result_type operator()() { return next(); }
+
+   private:
+    uint64_t state;
+    uint64_t increment;
+};
+
+// One stream per consumer, so adding draws in one system never shifts another system's sequence
+enum class RNG_STREAM {
+    ENEMY_SPAWNS = 0,
+    DISASTERS = ENEMY_SPAWNS + 1,
+    PARTICLES = DISASTERS + 1,
+    GACHA = PARTICLES + 1,
+    RNG_STREAM_COUNT = GACHA + 1
+};
+const int rng_stream_count = (int) RNG_STREAM::RNG_STREAM_COUNT;
+
+// Every random number in the game comes from here. A run is reproducible from its session seed
+// (together with the same input, see input_recording.hpp).
+class RngService {
+   public:
+    static RngService& getInstance();
+
+    // Reseeds every stream from the session seed
+    void seed(uint32_t session_seed);
+    uint32_t getSeed() const { return session_seed; }
+
+    Pcg32& stream(RNG_STREAM id) { return streams[(int) id]; }
+
+    RngService(const RngService&) = delete;
+    RngService& operator=(const RngService&) = delete;
+
+   private:
+    // seeded from std::random_device until seed() is called
+    RngService();
+
+    uint32_t session_seed = 0;
+    std::array<Pcg32, rng_stream_count> streams;
+};
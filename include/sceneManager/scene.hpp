@@ -3,6 +3,7 @@
 #include <glm/ext/vector_float2.hpp>
 #include <string>
 #include "bnuui/bnuui.hpp"
+#include "system_timings.hpp"
 class Scene {
 protected:
     std::string name;
@@ -17,7 +18,10 @@ public:
     virtual void HandleMouseMove(glm::vec2 mousePos) = 0;
     virtual void HandleMouseClick(int button, int action, int mods) = 0;
 
-    bnuui::SceneUI getUIElems() {
+    // Per-system times of scenes that step the game systems, nullptr for menus and cutscenes
+    virtual SystemTimings* getSystemTimings() { return nullptr; }
+
+    bnuui::SceneUI& getUIElems() {
         return scene_ui;
     }
 
@@ -13,6 +13,7 @@
 #include "render_system.hpp"
 #include "sound_system.hpp"
 #include "particle_system.hpp"
+#include "system_timings.hpp"
 
 // This class describes a parent class for Gameplay Levels.
 class GameLevel : public Scene {
@@ -45,6 +46,8 @@ private:
     std::shared_ptr<bnuui::Element> book;
     std::shared_ptr<bnuui::Element> book_icon;
     bool tracker_off_screen = true;
+
+    SystemTimings system_timings;
     
     virtual void LevelInit() = 0;
     virtual void LevelUpdate() = 0;
@@ -67,5 +70,8 @@ public:
 
     void UpdateDropoffProgressBar();
 
+    // Time spent in each system since the last reset
+    SystemTimings* getSystemTimings() override { return &system_timings; }
+
     virtual ~GameLevel() = default;
 }; 
@@ -0,0 +1,71 @@
+#pragma once
+
+// stlib
+#include <array>
+#include <chrono>
+
+#include "alloc_tracking.hpp"
+#include "profiler.hpp"
+
+// Systems stepped by GameLevel::Update, in update order
+enum class SIM_SYSTEM {
+    CAMERA = 0,
+    AI = CAMERA + 1,
+    PHYSICS = AI + 1,
+    ANIMATION = PHYSICS + 1,
+    MODULES = ANIMATION + 1,
+    PARTICLES = MODULES + 1,
+    COLLISIONS = PARTICLES + 1,
+    LIFETIMES = COLLISIONS + 1,  // projectile, laser and tornado expiry
+    LEVEL = LIFETIMES + 1,       // progress bar and the level's own update
+    UI = LEVEL + 1,
+    SIM_SYSTEM_COUNT = UI + 1
+};
+const int sim_system_count = (int) SIM_SYSTEM::SIM_SYSTEM_COUNT;
+
+const std::array<const char*, sim_system_count> sim_system_names = {
+    "camera", "ai", "physics", "animation", "modules", "particles", "collisions", "lifetimes", "level", "ui"};
+
+// Allocation zones (see alloc_tracking.hpp): one per system, then RenderSystem::draw
+inline int systemAllocationZone(SIM_SYSTEM system) {
+    return (int) system + 1;
+}
+const int render_allocation_zone = sim_system_count + 1;
+static_assert(render_allocation_zone < allocation_zone_count, "not enough allocation zones");
+
+// Wall time per system, summed over every update until reset
+struct SystemTimings {
+    std::array<double, sim_system_count> ms = {};
+    unsigned int updates = 0;
+
+    void reset() { *this = SystemTimings(); }
+};
+
+// Adds the time until the end of the scope to one system, and a zone named after it to the trace.
+// Allocations in the scope are attributed to the system.
+class ScopedSystemTimer {
+   public:
+    ScopedSystemTimer(SystemTimings& timings, SIM_SYSTEM system)
+        : timings(timings),
+          system(system),
+          allocation_zone(systemAllocationZone(system)),
+          start(std::chrono::steady_clock::now()) {}
+    ~ScopedSystemTimer() {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        timings.ms[(int) system] += elapsed.count();
+#ifdef BNUUY_PROFILE_ENABLED
+        if (Profiler::isCapturing()) {
+            Profiler::record(sim_system_names[(int) system],
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count(),
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count());
+        }
+#endif
+    }
+
+   private:
+    SystemTimings& timings;
+    SIM_SYSTEM system;
+    ScopedAllocationZone allocation_zone;
+    std::chrono::steady_clock::time_point start;
+};
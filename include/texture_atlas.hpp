@@ -0,0 +1,29 @@
+#pragma once
+
+#include "common.hpp"
+
+// stlib
+#include <cstdint>
+#include <vector>
+
+// Where a sprite landed in the atlas pages. page is -1 for sprites too large to pack.
+struct AtlasRegion {
+    int page = -1;
+    ivec2 position = {0, 0};  // top-left texel of the sprite, not of its padding
+    ivec2 size = {0, 0};
+};
+
+// Shelf packer: sprites are placed tallest first in rows, opening a new page when one fills.
+// Every sprite keeps padding texels on each side so NEAREST sampling never reads a neighbour.
+// Empty sprites and ones too big for a page are not placed (page -1). Returns the number of pages used.
+int packAtlasRegions(const std::vector<ivec2>& sizes, int page_size, int padding, std::vector<AtlasRegion>& regions);
+
+// Copies an RGBA sprite into an RGBA page and repeats its edge texels into the padding
+void copySpriteToAtlas(std::vector<uint8_t>& page,
+                       int page_size,
+                       const uint8_t* pixels,
+                       const AtlasRegion& region,
+                       int padding);
+
+// UV rect (u0, v0, u1, v1) of a region, in the same orientation as a standalone texture
+vec4 atlasUVRect(const AtlasRegion& region, int page_size);
@@ -25,6 +25,22 @@ struct Collision {
     }
 };
 
+// What an entity is as far as collision responses are concerned.
+enum class COLLISION_CATEGORY {
+    PLAYER_PROJECTILE = 0,
+    ENEMY_PROJECTILE = PLAYER_PROJECTILE + 1,
+    LASER_BEAM = ENEMY_PROJECTILE + 1,
+    ENEMY = LASER_BEAM + 1,
+    BUNNY = ENEMY + 1,
+    SHIP = BUNNY + 1,
+    ISLAND = SHIP + 1,
+    BASE = ISLAND + 1,
+    DISASTER = BASE + 1,
+    NONE = DISASTER + 1,
+    COLLISION_CATEGORY_COUNT = NONE + 1
+};
+const int collision_category_count = (int) COLLISION_CATEGORY::COLLISION_CATEGORY_COUNT;
+
 // Sets the brightness of the screen
 struct ScreenState {
     float darken_screen_factor = -1;
@@ -312,7 +328,9 @@ enum class EFFECT_ASSET_ID {
     FONT = VIGNETTE + 1,
     PARTICLE = FONT + 1,
     ALPHA = PARTICLE + 1,
-    EFFECT_COUNT = ALPHA + 1
+    SPRITE_BATCH = ALPHA + 1,
+    FONT_SDF = SPRITE_BATCH + 1,
+    EFFECT_COUNT = FONT_SDF + 1
 };
 const int effect_count = (int) EFFECT_ASSET_ID::EFFECT_COUNT;
 
@@ -366,13 +384,21 @@ struct Sound {
 };
 
 
-/* for ordering of rendering. so far (add to comment to keep track):
-1 = whirlpool
-2 = ship
-3 = tornado
-*/
+// for ordering of rendering, lower layers are drawn first. Within a layer sprites are grouped
+// by effect and texture so they can be batched, give sprites that must overlap in a fixed order
+// their own layer. Render requests without a RenderLayer are drawn on RENDER_LAYER_UNITS.
+enum RENDER_LAYER {
+    RENDER_LAYER_WATER = 0,
+    RENDER_LAYER_ISLAND = RENDER_LAYER_WATER + 1,
+    RENDER_LAYER_WHIRLPOOL = RENDER_LAYER_ISLAND + 1,
+    RENDER_LAYER_SHIP = RENDER_LAYER_WHIRLPOOL + 1,
+    RENDER_LAYER_MODULES = RENDER_LAYER_SHIP + 1,
+    RENDER_LAYER_UNITS = RENDER_LAYER_MODULES + 1,
+    RENDER_LAYER_TORNADO = RENDER_LAYER_UNITS + 1
+};
+
 struct RenderLayer {
-    int layer = 0;
+    int layer = RENDER_LAYER_UNITS;
 };
 
 enum DIRECTION { UP, RIGHT, DOWN, LEFT };
@@ -593,23 +619,48 @@ struct ParticleProps {
 	float LifeTime = 1.0f;
 };
 
-struct Particle {
-    glm::vec2 Position;
-    glm::vec2 Velocity;
-    glm::vec4 ColorBegin, ColorEnd;
-    float Rotation = 0.0f;
-    float SizeBegin, SizeEnd;
+// Structure-of-arrays particle storage. The live particles are packed in [0, count), a dying
+// particle is replaced by the last live one. Colors and sizes are not stored, the renderer
+// derives them from the emitter's props and the particle's remaining life.
+struct ParticlePool {
+    size_t count = 0;
+    std::vector<float> position_x, position_y;
+    std::vector<float> velocity_x, velocity_y;
+    std::vector<float> rotation;
+    std::vector<float> life_remaining;  // ms
+    std::vector<float> size_begin;
 
-    float LifeTime = 1.0f * 500.0f;
-    float LifeRemaining = 0.0f;
+    size_t capacity() const {
+        return position_x.size();
+    }
 
-    bool Active = false;
+    void resize(size_t capacity) {
+        position_x.resize(capacity);
+        position_y.resize(capacity);
+        velocity_x.resize(capacity);
+        velocity_y.resize(capacity);
+        rotation.resize(capacity);
+        life_remaining.resize(capacity);
+        size_begin.resize(capacity);
+        if (count > capacity) count = capacity;
+    }
+
+    // swap-remove, the particle that was last takes slot i
+    void kill(size_t i) {
+        count--;
+        position_x[i] = position_x[count];
+        position_y[i] = position_y[count];
+        velocity_x[i] = velocity_x[count];
+        velocity_y[i] = velocity_y[count];
+        rotation[i] = rotation[count];
+        life_remaining[i] = life_remaining[count];
+        size_begin[i] = size_begin[count];
+    }
 };
 
 struct ParticleEmitter {
     ParticleProps props;
-    std::vector<Particle> particles;
-    uint32_t poolIndex = 999;
+    ParticlePool particles;
 
     float delay_ms = DEFAULT_PARTICLE_TIME;
 };
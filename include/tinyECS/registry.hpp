@@ -7,6 +7,13 @@
 class ECSRegistry {
     // callbacks to remove a particular or all entities in the system
     std::vector<ContainerInterface*> registry_list;
+    // member name of each container, for debug output and the frame statistics
+    std::vector<const char*> registry_names;
+
+    void add_container(ContainerInterface& container, const char* name) {
+        registry_list.push_back(&container);
+        registry_names.push_back(name);
+    }
 
    public:
     // Manually created list of all components this game has
@@ -61,50 +68,50 @@ class ECSRegistry {
 
     // constructor that adds all containers for looping over them
     ECSRegistry() {
-        registry_list.push_back(&renderRequests);
-        registry_list.push_back(&renderLayers);
-        registry_list.push_back(&gridLines);
-        registry_list.push_back(&overlays);
-        registry_list.push_back(&spotlights);
-        registry_list.push_back(&screenStates);
-        registry_list.push_back(&colors);
-
-        registry_list.push_back(&players);
-        registry_list.push_back(&playerAnimations);
-
-        registry_list.push_back(&ships);
+        add_container(renderRequests, "renderRequests");
+        add_container(renderLayers, "renderLayers");
+        add_container(gridLines, "gridLines");
+        add_container(overlays, "overlays");
+        add_container(spotlights, "spotlights");
+        add_container(screenStates, "screenStates");
+        add_container(colors, "colors");
+
+        add_container(players, "players");
+        add_container(playerAnimations, "playerAnimations");
+
+        add_container(ships, "ships");
         
-        registry_list.push_back(&motions);
-        registry_list.push_back(&collisions);
-        registry_list.push_back(&sounds);
+        add_container(motions, "motions");
+        add_container(collisions, "collisions");
+        add_container(sounds, "sounds");
         
-        registry_list.push_back(&backgroundObjects);
-        registry_list.push_back(&cameras);
+        add_container(backgroundObjects, "backgroundObjects");
+        add_container(cameras, "cameras");
 
-        registry_list.push_back(&islands);
-        registry_list.push_back(&base);
+        add_container(islands, "islands");
+        add_container(base, "base");
 
-        registry_list.push_back(&steeringWheels);
-        registry_list.push_back(&simpleCannons);
+        add_container(steeringWheels, "steeringWheels");
+        add_container(simpleCannons, "simpleCannons");
 
-        registry_list.push_back(&cannonModifiers);
+        add_container(cannonModifiers, "cannonModifiers");
 
-        registry_list.push_back(&laserWeapons);
-        registry_list.push_back(&laserBeams);
+        add_container(laserWeapons, "laserWeapons");
+        add_container(laserBeams, "laserBeams");
 
-        registry_list.push_back(&healModules);
+        add_container(healModules, "healModules");
         
-        registry_list.push_back(&enemies);
-        registry_list.push_back(&enemySpawners);
+        add_container(enemies, "enemies");
+        add_container(enemySpawners, "enemySpawners");
 
-        registry_list.push_back(&bunnies);
-        registry_list.push_back(&walkingPaths);
-        registry_list.push_back(&filledTiles);
+        add_container(bunnies, "bunnies");
+        add_container(walkingPaths, "walkingPaths");
+        add_container(filledTiles, "filledTiles");
 
-        registry_list.push_back(&disasters);
-        registry_list.push_back(&helperBunnyIcons);
+        add_container(disasters, "disasters");
+        add_container(helperBunnyIcons, "helperBunnyIcons");
 
-        registry_list.push_back(&particleEmitters);
+        add_container(particleEmitters, "particleEmitters");
     }
 
     void clear_all_components() {
@@ -113,10 +120,14 @@ class ECSRegistry {
 
     void list_all_components() {
         printf("Debug info on all registry entries:\n");
-        for (ContainerInterface* reg : registry_list)
-            if (reg->size() > 0) printf("%4d components of type %s\n", (int) reg->size(), typeid(*reg).name());
+        for (size_t i = 0; i < registry_list.size(); i++)
+            if (registry_list[i]->size() > 0) printf("%4d %s\n", (int) registry_list[i]->size(), registry_names[i]);
     }
 
+    size_t container_count() const { return registry_list.size(); }
+    const char* container_name(size_t i) const { return registry_names[i]; }
+    size_t container_size(size_t i) const { return registry_list[i]->size(); }
+
     void list_all_components_of(Entity e) {
         printf("Debug info on components of entity %u:\n", (unsigned int) e);
         for (ContainerInterface* reg : registry_list)
@@ -0,0 +1,45 @@
+#pragma once
+
+// stlib
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that run batches of independent tasks. The calling thread
+// takes part in every batch, so a pool with no workers just runs the tasks inline.
+// Workers attribute their allocations to the caller's allocation zone.
+class WorkerPool {
+   public:
+    explicit WorkerPool(unsigned int worker_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // number of threads a batch is spread over, including the caller
+    unsigned int threadCount() const { return (unsigned int) workers.size() + 1; }
+
+    // runs job(task) for every task in [0, task_count) and returns once all of them are done
+    void run(size_t task_count, const std::function<void(size_t)>& job);
+
+   private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* current_job = nullptr;
+    size_t current_task_count = 0;
+    int current_allocation_zone = 0;
+    std::atomic<size_t> next_task{0};
+    unsigned int busy_workers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
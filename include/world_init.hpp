@@ -36,6 +36,8 @@ Entity createCamera();
 Entity createGridLine(vec2 start_pos, vec2 end_pos);
 Entity createOverlay(float alpha, vec3 color = vec3(0));
 
+// Corners of the motion's rotated box: top left, top right, bottom right, bottom left
+std::array<tson::Vector2i, 4> get_corners_from_motion(const Motion& motion);
 std::vector<tson::Vector2i> get_poly_from_motion(const Motion& motion);
 std::vector<Entity> createBaseProgressLines(Entity base_entity);
 
@@ -5,12 +5,13 @@
 
 // stlib
 #include <vector>
-#include <random>
 
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+#include "collision_dispatch.hpp"
+#include "input_recording.hpp"
 #include "render_system.hpp"
 
 // Container for all our entities and game logic.
@@ -53,29 +54,46 @@ class WorldSystem {
     // should the game be over ?
     bool is_over() const;
 
-    // change title
-    void add_to_title(std::string title);
+    // bunnies saved in the current level, shown in the title from the next refresh
+    void set_title_progress(int bunnies_saved, int bunnies_to_win);
+    // shows the FPS and the title text, main() calls it once a second
+    void refresh_title();
 
     int getFPScounter();
 
     static bool isExitPressed;
 
+    // input callback functions, also driven directly by the headless simulation runner and input replays
+    void on_key(int key, int, int action, int mod);
+    void on_mouse_move(vec2 pos);
+    void on_mouse_button_pressed(int button, int action, int mods);
+
+    // Every input callback is also handed to the recorder, null stops recording
+    void setInputRecorder(InputRecorder* recorder) { input_recorder = recorder; }
+    // While false the window's input is dropped, so a replay is not mixed with live input
+    void setLiveInput(bool enabled) { live_input = enabled; }
+
    private:
     float mouse_pos_x = 0.0f;
     float mouse_pos_y = 0.0f;
 
-    std::string title_points = "";
-
-    // input callback functions
-    void on_key(int key, int, int action, int mod);
-    void on_mouse_move(vec2 pos);
-    void on_mouse_button_pressed(int button, int action, int mods);
+    int title_bunnies_saved = -1;  // -1 until a level sets it
+    int title_bunnies_to_win = 0;
+    std::string shown_title;
 
     // restart level
     void restart_game();
 
-    // OpenGL window handle
-    GLFWwindow* window;
+    // fills the collision dispatch table
+    void register_collision_handlers();
+    CollisionDispatcher collision_dispatcher;
+
+    // OpenGL window handle, stays null for the headless and null render backends
+    GLFWwindow* window = nullptr;
+    bool should_close = false;
+
+    InputRecorder* input_recorder = nullptr;
+    bool live_input = true;
 
     // Game state
     RenderSystem* renderer;
@@ -92,8 +110,4 @@ class WorldSystem {
     Mix_Chunk* projectile_jail_collision;
     Mix_Chunk* projectile_enemy_collision;
     Mix_Chunk* game_over;*/
-
-    // C++ random number generator
-    std::default_random_engine rng;
-    std::uniform_real_distribution<float> uniform_dist;  // number between 0..1
 };
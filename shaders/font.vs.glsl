@@ -1,13 +1,15 @@
 #version 330 core
 /* simpleGL freetype font vertex shader */
 layout (location = 0) in vec4 vertex;	// vec4 = vec2 pos (xy) + vec2 tex (zw)
+layout (location = 1) in vec3 in_color;
 out vec2 TexCoords;
+out vec3 vcolor;
 
 uniform mat4 projection;
-uniform mat4 transform;
 
 void main()
 {
-	gl_Position = projection * transform * vec4(vertex.xy, 0.0, 1.0);
+	gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
 	TexCoords = vertex.zw;
+	vcolor = in_color;
 }
@@ -0,0 +1,17 @@
+#version 330 core
+/* signed distance field font fragment shader */
+in vec2 TexCoords;
+in vec3 vcolor;
+out vec4 color;
+
+// 0.5 on the glyph outline, rising towards the inside
+uniform sampler2D text;
+
+void main()
+{
+	float distance = texture(text, TexCoords).r;
+	// antialias over about one screen pixel whatever the font scale
+	float width = fwidth(distance);
+	float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+	color = vec4(vcolor, alpha);
+}
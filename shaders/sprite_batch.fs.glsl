@@ -0,0 +1,16 @@
+#version 330
+
+// From vertex shader
+in vec2 texcoord;
+in vec4 vtint;
+
+// Application data
+uniform sampler2D sampler0;
+
+// Output color
+layout(location = 0) out  vec4 color;
+
+void main()
+{
+	color = vtint * texture(sampler0, vec2(texcoord.x, texcoord.y));
+}
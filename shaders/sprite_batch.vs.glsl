@@ -0,0 +1,35 @@
+#version 330
+
+// Input attributes, the SPRITE quad
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec2 in_texcoord;
+
+// Per-instance attributes, see SpriteInstance
+layout(location = 2) in vec2 instance_position;
+layout(location = 3) in vec2 instance_scale;
+layout(location = 4) in float instance_angle;	// degrees
+layout(location = 5) in vec4 instance_uv_rect;	// (u0, v0, u1, v1)
+layout(location = 6) in vec4 instance_tint;
+
+// Passed to fragment shader
+out vec2 texcoord;
+out vec4 vtint;
+
+// Application data
+uniform mat3 projection;
+
+void main()
+{
+	// translate * scale * rotate, as Transform builds it on the CPU
+	float c = cos(radians(instance_angle));
+	float s = sin(radians(instance_angle));
+	mat3 transform = mat3(
+		vec3(instance_scale.x * c, instance_scale.y * s, 0.0),
+		vec3(-instance_scale.x * s, instance_scale.y * c, 0.0),
+		vec3(instance_position, 1.0));
+
+	texcoord = mix(instance_uv_rect.xy, instance_uv_rect.zw, in_texcoord);
+	vtint = instance_tint;
+	vec3 pos = projection * transform * vec3(in_position, 1.0);
+	gl_Position = vec4(pos.xy, 0.0, 1.0);
+}
\ No newline at end of file
@@ -10,10 +10,12 @@ out vec2 texcoord;
 // Application data
 uniform mat3 transform;
 uniform mat3 projection;
+// Region of the bound texture to map the quad to, (u0, v0, u1, v1)
+uniform vec4 uv_rect;
 
 void main()
 {
-	texcoord = in_texcoord;
+	texcoord = mix(uv_rect.xy, uv_rect.zw, in_texcoord);
 	vec3 pos = projection * transform * vec3(in_position.xy, 1.0);
 	gl_Position = vec4(pos.xy, in_position.z, 1.0);
 }
\ No newline at end of file
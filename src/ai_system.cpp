@@ -7,8 +7,9 @@
 #include "world_init.hpp"
 #include "pathing.hpp"
 #include "physics_system.hpp"
+#include "profiler.hpp"
 
-#include <queue>
+#include <algorithm>
 
 void AISystem::step(float elapsed_ms) {
     (void) elapsed_ms;
@@ -26,7 +27,7 @@ void AISystem::step(float elapsed_ms) {
                 std::vector<ivec2> path;
                 if (find_path(path, enemy_entity, ship_entity)) {
                     WalkingPath& walkingPath = registry.walkingPaths.emplace(enemy_entity);
-                    walkingPath.path = path;
+                    walkingPath.path = std::move(path);
                 } else {
                     // just remove the enemy if path is not found, otherwise it gets really laggy
                     registry.remove_all_components_of(enemy_entity);
@@ -90,6 +91,7 @@ void AISystem::step(float elapsed_ms) {
 // If a path is not found, return false.
 bool AISystem::find_path(std::vector<ivec2> & path, Entity enemy_entity, Entity ship_entity)
 {
+    PROFILE_ZONE("ai.find_path");
     Motion& ship_motion = registry.motions.get(ship_entity);
     vec2 ship_position_with_camera = ship_motion.position - CameraSystem::GetInstance()->position;
     ivec2 ship_node_position = {(ship_position_with_camera.x - GRID_CELL_WIDTH_PX / 2) / GRID_CELL_WIDTH_PX, (ship_position_with_camera.y - GRID_CELL_HEIGHT_PX / 2) / GRID_CELL_HEIGHT_PX};
@@ -115,15 +117,18 @@ bool AISystem::find_path(std::vector<ivec2> & path, Entity enemy_entity, Entity
         return a.F > b.F;
     };
 
-    std::priority_queue<Node, std::vector<Node>, decltype(comparator)> open_nodes(comparator);
-    std::vector<Node> closed_nodes;
-    open_nodes.push(enemy_node);
+    // a binary heap like std::priority_queue, but in a plain vector so the open check can scan it
+    FrameVector<Node> open_nodes;
+    FrameVector<Node> closed_nodes;
+    FrameVector<ivec2> neighbours;
+    open_nodes.push_back(enemy_node);
 
     // use A*
     // return true when a path is found and return the path via the &path vector
     while (open_nodes.size() > 0) {
-        Node current_node = open_nodes.top();
-        open_nodes.pop();
+        std::pop_heap(open_nodes.begin(), open_nodes.end(), comparator);
+        Node current_node = open_nodes.back();
+        open_nodes.pop_back();
         closed_nodes.push_back(current_node);
     
         if (current_node == ship_node) {
@@ -137,7 +142,8 @@ bool AISystem::find_path(std::vector<ivec2> & path, Entity enemy_entity, Entity
             return true;
         }
     
-        for (ivec2 neighbour : get_walkable_neighbours(current_node)) {
+        get_walkable_neighbours(current_node, neighbours);
+        for (ivec2 neighbour : neighbours) {
             Node neighbour_node = Node({neighbour.x, neighbour.y}, current_node.position, 0, 0);
 
             // check if node is already closed
@@ -146,15 +152,9 @@ bool AISystem::find_path(std::vector<ivec2> & path, Entity enemy_entity, Entity
             uint new_neighbour_G = current_node.G + get_distance(current_node, neighbour_node);
 
             // check if node is already open
-            bool is_open = false;
-            auto temp = open_nodes;
-            while (!temp.empty()) {
-                if (temp.top().position == neighbour_node.position) {
-                    is_open = true;
-                    break;
-                }
-                temp.pop();
-            }
+            bool is_open = std::any_of(open_nodes.begin(), open_nodes.end(), [&](const Node& node) {
+                return node.position == neighbour_node.position;
+            });
 
             if (new_neighbour_G < neighbour_node.G || !is_open) {
 
@@ -164,7 +164,8 @@ bool AISystem::find_path(std::vector<ivec2> & path, Entity enemy_entity, Entity
                 neighbour_node.parent = current_node.position;
 
                 if (!is_open) {
-                    open_nodes.push(neighbour_node);
+                    open_nodes.push_back(neighbour_node);
+                    std::push_heap(open_nodes.begin(), open_nodes.end(), comparator);
                 }
             }
         }
@@ -185,9 +186,9 @@ uint AISystem::get_distance(Node node1, Node node2) {
 	return 14 * dstX + 10 * (dstY - dstX);
 }
 
-std::vector<ivec2> AISystem::get_walkable_neighbours(Node node) {
-    std::vector<ivec2> neighbours;
-    std::vector<ivec2> possible_neighbours = {
+void AISystem::get_walkable_neighbours(Node node, FrameVector<ivec2>& neighbours) {
+    neighbours.clear();
+    const ivec2 possible_neighbours[] = {
         {node.position.x - 1, node.position.y - 1},     // top left
         {node.position.x, node.position.y - 1},         // top middle
         {node.position.x + 1, node.position.y - 1},     // top botom
@@ -210,11 +211,9 @@ std::vector<ivec2> AISystem::get_walkable_neighbours(Node node) {
         if (!should_add) continue;
         neighbours.push_back(neighbour);
     }
-
-    return neighbours;
 }
 
-std::vector<ivec2> AISystem::retrace_path(std::vector<Node> visited_nodes, Node start_node, Node exit_node) {
+std::vector<ivec2> AISystem::retrace_path(const FrameVector<Node>& visited_nodes, Node start_node, Node exit_node) {
 	std::vector<ivec2> path;
 	Node current_node = exit_node;
 
@@ -0,0 +1,75 @@
+#include "alloc_tracking.hpp"
+
+// stlib
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// the physics workers allocate too, so the counters are shared; relaxed is enough for statistics
+std::atomic<uint64_t> allocation_count{0};
+std::atomic<uint64_t> free_count{0};
+std::atomic<uint64_t> allocated_bytes{0};
+
+// frees are not attributed, the zone that frees a block is rarely the one that allocated it
+std::array<std::atomic<uint64_t>, allocation_zone_count> zone_allocation_count = {};
+std::array<std::atomic<uint64_t>, allocation_zone_count> zone_allocated_bytes = {};
+
+// constant initialised, so operator new can use it before anything else has run
+thread_local int current_zone = 0;
+
+}  // namespace
+
+AllocationTotals allocationTotals() {
+    AllocationTotals totals;
+    totals.allocations = allocation_count.load(std::memory_order_relaxed);
+    totals.frees = free_count.load(std::memory_order_relaxed);
+    totals.bytes = allocated_bytes.load(std::memory_order_relaxed);
+    return totals;
+}
+
+AllocationTotals allocationTotals(int zone) {
+    assert(zone >= 0 && zone < allocation_zone_count);
+    AllocationTotals totals;
+    totals.allocations = zone_allocation_count[zone].load(std::memory_order_relaxed);
+    totals.bytes = zone_allocated_bytes[zone].load(std::memory_order_relaxed);
+    return totals;
+}
+
+int currentAllocationZone() {
+    return current_zone;
+}
+
+ScopedAllocationZone::ScopedAllocationZone(int zone) : previous(current_zone) {
+    assert(zone >= 0 && zone < allocation_zone_count);
+    current_zone = zone;
+}
+
+ScopedAllocationZone::~ScopedAllocationZone() {
+    current_zone = previous;
+}
+
+// The array, nothrow and sized forms forward to these by default, so replacing the two plain ones sees
+// every allocation that does not ask for extended alignment.
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    zone_allocation_count[current_zone].fetch_add(1, std::memory_order_relaxed);
+    zone_allocated_bytes[current_zone].fetch_add(size, std::memory_order_relaxed);
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) return;
+    free_count.fetch_add(1, std::memory_order_relaxed);
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
@@ -542,7 +542,10 @@ void TextLabel::doUpdate(float dt) {
 }
 
 void TextLabel::setText(const std::string& text) {
+    // labels are often set every frame, only a real change invalidates the cached layout
+    if (this->text == text) return;
     this->text = text;
+    this->text_revision = ++next_text_revision;
 }
 
 DialogueBox::DialogueBox(vec2 pos, vec2 scale, float rot, bool on_top) {
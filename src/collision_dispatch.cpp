@@ -0,0 +1,123 @@
+#include "collision_dispatch.hpp"
+#include "tinyECS/registry.hpp"
+
+// stlib
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+COLLISION_CATEGORY getCollisionCategory(Entity entity) {
+    if (registry.playerProjectiles.has(entity)) return COLLISION_CATEGORY::PLAYER_PROJECTILE;
+    if (registry.enemyProjectiles.has(entity)) return COLLISION_CATEGORY::ENEMY_PROJECTILE;
+    if (registry.laserBeams.has(entity)) return COLLISION_CATEGORY::LASER_BEAM;
+    if (registry.enemies.has(entity)) return COLLISION_CATEGORY::ENEMY;
+    if (registry.bunnies.has(entity)) return COLLISION_CATEGORY::BUNNY;
+    if (registry.ships.has(entity)) return COLLISION_CATEGORY::SHIP;
+    if (registry.islands.has(entity)) return COLLISION_CATEGORY::ISLAND;
+    if (registry.base.has(entity)) return COLLISION_CATEGORY::BASE;
+    if (registry.disasters.has(entity)) return COLLISION_CATEGORY::DISASTER;
+    return COLLISION_CATEGORY::NONE;
+}
+
+void CollisionDispatcher::registerHandler(COLLISION_CATEGORY a, COLLISION_CATEGORY b, CollisionHandler handler) {
+    bool swapped = a > b;
+    if (swapped) std::swap(a, b);
+
+    HandlerSlot& slot = handlers[(int) a * collision_category_count + (int) b];
+    assert(!slot.handler && "collision handler registered twice for the same pair");
+    slot.handler = std::move(handler);
+    slot.swapped = swapped;
+}
+
+void CollisionDispatcher::registerContactHandler(COLLISION_CATEGORY a,
+                                                 COLLISION_CATEGORY b,
+                                                 ContactHandler handler,
+                                                 float exit_grace_ms) {
+    ContactCache::getInstance().setExitGrace(a, b, exit_grace_ms);
+    bool swapped = a > b;
+    if (swapped) std::swap(a, b);
+
+    ContactHandlerSlot& slot = contact_handlers[(int) a * collision_category_count + (int) b];
+    assert(!slot.handler && "contact handler registered twice for the same pair");
+    slot.handler = std::move(handler);
+    slot.swapped = swapped;
+}
+
+bool CollisionDispatcher::dispatch() {
+    ContactCache& contact_cache = ContactCache::getInstance();
+    for (const ContactEvent& event : contact_cache.getEvents()) {
+        const Contact& contact = event.contact;
+        Entity a = contact.a;
+        Entity b = contact.b;
+        COLLISION_CATEGORY category_a = contact.category_a;
+        COLLISION_CATEGORY category_b = contact.category_b;
+        if (category_a > category_b) {
+            std::swap(category_a, category_b);
+            std::swap(a, b);
+        }
+
+        const ContactHandlerSlot& slot =
+            contact_handlers[(int) category_a * collision_category_count + (int) category_b];
+        if (!slot.handler) continue;
+        if (event.type != CONTACT_EVENT::EXIT && (!registry.motions.has(a) || !registry.motions.has(b))) continue;
+
+        if (slot.swapped) {
+            slot.handler(event.type, b, a, contact);
+        } else {
+            slot.handler(event.type, a, b, contact);
+        }
+    }
+    contact_cache.clearEvents();
+
+    ComponentContainer<Collision>& collision_container = registry.collisions;
+
+    pending.clear();
+    for (uint i = 0; i < collision_container.components.size(); i++) {
+        Entity e1 = collision_container.entities[i];
+        Entity e2 = collision_container.components[i].other;
+        unsigned int id1 = e1;
+        unsigned int id2 = e2;
+        pending.push_back({e1, e2, collision_container.components[i].normal, std::min(id1, id2), std::max(id1, id2)});
+    }
+    // the handlers work on the copies, removing entities below no longer touches the records
+    collision_container.clear();
+
+    // coalesce (e1, e2) and (e2, e1) into a single record, keeping the first one reported
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingCollision& l, const PendingCollision& r) {
+        return l.lo != r.lo ? l.lo < r.lo : l.hi < r.hi;
+    });
+    pending.erase(std::unique(pending.begin(),
+                              pending.end(),
+                              [](const PendingCollision& l, const PendingCollision& r) {
+                                  return l.lo == r.lo && l.hi == r.hi;
+                              }),
+                  pending.end());
+
+    for (PendingCollision& p : pending) {
+        Entity a = p.first;
+        Entity b = p.second;
+        // an earlier handler may have removed one of them
+        if (!registry.motions.has(a) || !registry.motions.has(b)) continue;
+
+        COLLISION_CATEGORY category_a = getCollisionCategory(a);
+        COLLISION_CATEGORY category_b = getCollisionCategory(b);
+        if (category_a > category_b) {
+            std::swap(category_a, category_b);
+            std::swap(a, b);
+        }
+
+        const HandlerSlot& slot = handlers[(int) category_a * collision_category_count + (int) category_b];
+        if (!slot.handler) continue;
+
+        bool keep_going;
+        if (slot.swapped) {
+            Collision collision(a, p.normal);
+            keep_going = slot.handler(b, a, collision);
+        } else {
+            Collision collision(b, p.normal);
+            keep_going = slot.handler(a, b, collision);
+        }
+        if (!keep_going) return false;
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+#include "contact_cache.hpp"
+#include "collision_dispatch.hpp"
+#include "tinyECS/registry.hpp"
+
+// stlib
+#include <algorithm>
+
+ContactCache& ContactCache::getInstance() {
+    static ContactCache instance;
+    return instance;
+}
+
+void ContactCache::setExitGrace(COLLISION_CATEGORY a, COLLISION_CATEGORY b, float ms) {
+    if (a > b) std::swap(a, b);
+    exit_grace_ms[(int) a * collision_category_count + (int) b] = ms;
+}
+
+float ContactCache::exitGraceMs(const Contact& contact) const {
+    COLLISION_CATEGORY a = std::min(contact.category_a, contact.category_b);
+    COLLISION_CATEGORY b = std::max(contact.category_a, contact.category_b);
+    return exit_grace_ms[(int) a * collision_category_count + (int) b];
+}
+
+uint64_t ContactCache::key(Entity e1, Entity e2) {
+    uint64_t id1 = (unsigned int) e1;
+    uint64_t id2 = (unsigned int) e2;
+    return id1 < id2 ? (id1 << 32) | id2 : (id2 << 32) | id1;
+}
+
+void ContactCache::update(float elapsed_ms) {
+    step_count++;
+
+    ComponentContainer<Collision>& collision_container = registry.collisions;
+    for (uint i = 0; i < collision_container.components.size(); i++) {
+        Entity e1 = collision_container.entities[i];
+        Entity e2 = collision_container.components[i].other;
+        vec2 mtv = collision_container.components[i].normal;
+
+        auto it = contacts.find(key(e1, e2));
+        if (it == contacts.end()) {
+            Contact contact;
+            if ((unsigned int) e1 > (unsigned int) e2) std::swap(e1, e2);
+            contact.a = e1;
+            contact.b = e2;
+            contact.category_a = getCollisionCategory(e1);
+            contact.category_b = getCollisionCategory(e2);
+            contact.mtv = mtv;
+            contact.prev_mtv = mtv;
+            contact.last_step = step_count;
+            contacts.emplace(key(e1, e2), contact);
+            events.push_back({CONTACT_EVENT::ENTER, contact});
+            continue;
+        }
+
+        // duplicate record of a pair already refreshed this step
+        Contact& contact = it->second;
+        if (contact.last_step == step_count) continue;
+
+        contact.prev_mtv = contact.mtv;
+        contact.mtv = mtv;
+        // a pair that was apart within the grace period starts counting again, duration is unbroken contact
+        contact.duration_ms = contact.missing_ms > 0 ? 0 : contact.duration_ms + elapsed_ms;
+        contact.missing_ms = 0;
+        contact.last_step = step_count;
+        events.push_back({CONTACT_EVENT::STAY, contact});
+    }
+
+    // pairs not reported this step exit once they have been apart for a little while, so a ship
+    // scraping along an island does not re-enter every other frame
+    expired.clear();
+    for (auto& [k, contact] : contacts) {
+        if (contact.last_step == step_count) continue;
+        contact.missing_ms += elapsed_ms;
+        if (contact.missing_ms > exitGraceMs(contact) || !registry.motions.has(contact.a) ||
+            !registry.motions.has(contact.b)) {
+            expired.push_back(k);
+        }
+    }
+    // unordered_map order is not stable, keep the EXIT events in pair order
+    std::sort(expired.begin(), expired.end());
+    for (uint64_t k : expired) {
+        auto it = contacts.find(k);
+        events.push_back({CONTACT_EVENT::EXIT, it->second});
+        contacts.erase(it);
+    }
+}
+
+const Contact* ContactCache::find(Entity e1, Entity e2) const {
+    auto it = contacts.find(key(e1, e2));
+    return it == contacts.end() ? nullptr : &it->second;
+}
+
+void ContactCache::clear() {
+    contacts.clear();
+    events.clear();
+}
@@ -0,0 +1,239 @@
+#include "font_atlas.hpp"
+#include "texture_atlas.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// fonts
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace {
+
+const uint32_t font_cache_magic = 0x544e4642;  // "BFNT"
+const uint32_t font_cache_version = 1;
+const float distance_infinity = 1e20f;
+
+// Squared distance to the nearest zero of f along one row or column (Felzenszwalb & Huttenlocher).
+// v and z are scratch arrays of n and n + 1 elements.
+void distanceTransform1D(const float* f, int n, float* d, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -distance_infinity;
+    z[1] = distance_infinity;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = distance_infinity;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) k++;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+// In place: grid holds 0 on features and distance_infinity elsewhere
+void distanceTransform2D(std::vector<float>& grid, int width, int height) {
+    int n = std::max(width, height);
+    std::vector<float> f(n);
+    std::vector<float> d(n);
+    std::vector<int> v(n);
+    std::vector<float> z(n + 1);
+
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) f[y] = grid[y * width + x];
+        distanceTransform1D(f.data(), height, d.data(), v.data(), z.data());
+        for (int y = 0; y < height; y++) grid[y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; y++) {
+        distanceTransform1D(&grid[y * width], width, d.data(), v.data(), z.data());
+        std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+    }
+}
+
+long long fileSize(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) return -1;
+    return (long long) file.tellg();
+}
+
+template <typename T>
+void writeValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+    return (bool) file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+void computeSignedDistanceField(const uint8_t* coverage, ivec2 size, int spread, std::vector<uint8_t>& field) {
+    int width = size.x + 2 * spread;
+    int height = size.y + 2 * spread;
+
+    // distances to the nearest inside texel and to the nearest outside texel
+    std::vector<float> to_inside(width * height, distance_infinity);
+    std::vector<float> to_outside(width * height, 0.f);
+    for (int y = 0; y < size.y; y++) {
+        for (int x = 0; x < size.x; x++) {
+            if (coverage[y * size.x + x] < 128) continue;
+            int i = (y + spread) * width + x + spread;
+            to_inside[i] = 0.f;
+            to_outside[i] = distance_infinity;
+        }
+    }
+    distanceTransform2D(to_inside, width, height);
+    distanceTransform2D(to_outside, width, height);
+
+    // the outline sits half a texel from the centres on either side of it
+    field.resize(width * height);
+    for (int i = 0; i < width * height; i++) {
+        float distance = to_inside[i] == 0.f ? std::sqrt(to_outside[i]) - 0.5f : 0.5f - std::sqrt(to_inside[i]);
+        float value = std::min(std::max(0.5f + distance / (2.f * spread), 0.f), 1.f);
+        field[i] = (uint8_t) std::lround(value * 255.f);
+    }
+}
+
+bool bakeFontAtlas(const std::string& font_filename, int bake_size, int spread, FontAtlas& atlas) {
+    FT_Library ft;
+    if (FT_Init_FreeType(&ft))
+    {
+        std::cerr << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return false;
+    }
+
+    FT_Face face;
+    if (FT_New_Face(ft, font_filename.c_str(), 0, &face))
+    {
+        std::cerr << "ERROR::FREETYPE: Failed to load font: " << font_filename << std::endl;
+        FT_Done_FreeType(ft);
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, bake_size);
+
+    atlas.bake_size = bake_size;
+    atlas.spread = spread;
+    atlas.glyphs = {};
+
+    std::array<std::vector<uint8_t>, 128> bitmaps;
+    std::vector<ivec2> sizes(128, ivec2(0));
+    std::vector<uint8_t> coverage;
+    for (int c = 0; c < 128; c++) {
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+        {
+            std::cerr << "ERROR::FREETYTPE: Failed to load Glyph " << c << std::endl;
+            continue;
+        }
+
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        ivec2 bitmap_size(bitmap.width, bitmap.rows);
+        coverage.resize(bitmap.width * bitmap.rows);
+        for (unsigned int row = 0; row < bitmap.rows; row++) {
+            std::memcpy(coverage.data() + row * bitmap.width, bitmap.buffer + row * bitmap.pitch, bitmap.width);
+        }
+
+        // blank glyphs such as space only advance the pen
+        int border = bitmap_size.x > 0 && bitmap_size.y > 0 ? spread : 0;
+        if (border > 0) {
+            computeSignedDistanceField(coverage.data(), bitmap_size, spread, bitmaps[c]);
+        } else {
+            bitmaps[c] = coverage;
+        }
+        sizes[c] = bitmap_size + 2 * border;
+
+        FontGlyph& glyph = atlas.glyphs[c];
+        glyph.size = sizes[c];
+        glyph.bearing = vec2(face->glyph->bitmap_left - border, face->glyph->bitmap_top + border);
+        glyph.advance = face->glyph->advance.x / 64.f;
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    // smallest power of two page that fits every glyph, the 1px gutter stays empty so glyphs never bleed.
+    // A glyph wider than the page is left unplaced rather than spilling, so that grows the page too.
+    atlas.size = 64;
+    std::vector<AtlasRegion> regions;
+    auto fits = [&]() {
+        if (packAtlasRegions(sizes, atlas.size, 1, regions) > 1) return false;
+        for (int c = 0; c < 128; c++) {
+            if (regions[c].page < 0 && sizes[c].x > 0 && sizes[c].y > 0) return false;
+        }
+        return true;
+    };
+    while (!fits()) atlas.size *= 2;
+
+    atlas.pixels.assign(atlas.size * atlas.size, 0);
+    for (int c = 0; c < 128; c++) {
+        if (regions[c].page < 0 || sizes[c].x == 0 || sizes[c].y == 0) continue;
+        for (int row = 0; row < sizes[c].y; row++) {
+            std::memcpy(atlas.pixels.data() + (regions[c].position.y + row) * atlas.size + regions[c].position.x,
+                        bitmaps[c].data() + row * sizes[c].x,
+                        sizes[c].x);
+        }
+        atlas.glyphs[c].uv_rect = atlasUVRect(regions[c], atlas.size);
+    }
+    return true;
+}
+
+bool loadFontAtlasCache(const std::string& cache_filename,
+                        const std::string& font_filename,
+                        int bake_size,
+                        int spread,
+                        FontAtlas& atlas) {
+    std::ifstream file(cache_filename, std::ios::binary);
+    if (!file) return false;
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    long long font_bytes = 0;
+    if (!readValue(file, magic) || !readValue(file, version) || !readValue(file, font_bytes)) return false;
+    if (magic != font_cache_magic || version != font_cache_version || font_bytes != fileSize(font_filename)) {
+        return false;
+    }
+
+    FontAtlas cached;
+    if (!readValue(file, cached.bake_size) || !readValue(file, cached.spread) || !readValue(file, cached.size)) {
+        return false;
+    }
+    if (cached.bake_size != bake_size || cached.spread != spread || cached.size <= 0) return false;
+    if (!readValue(file, cached.glyphs)) return false;
+
+    cached.pixels.resize(cached.size * cached.size);
+    if (!file.read(reinterpret_cast<char*>(cached.pixels.data()), cached.pixels.size())) return false;
+
+    atlas = std::move(cached);
+    return true;
+}
+
+bool saveFontAtlasCache(const std::string& cache_filename, const std::string& font_filename, const FontAtlas& atlas) {
+    std::ofstream file(cache_filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Could not write font atlas cache: " << cache_filename << std::endl;
+        return false;
+    }
+
+    writeValue(file, font_cache_magic);
+    writeValue(file, font_cache_version);
+    writeValue(file, fileSize(font_filename));
+    writeValue(file, atlas.bake_size);
+    writeValue(file, atlas.spread);
+    writeValue(file, atlas.size);
+    writeValue(file, atlas.glyphs);
+    file.write(reinterpret_cast<const char*>(atlas.pixels.data()), atlas.pixels.size());
+    return (bool) file;
+}
@@ -0,0 +1,113 @@
+#include "frame_arena.hpp"
+
+// stlib
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include "common.hpp"
+
+namespace {
+
+const unsigned char poison_byte = 0xDD;
+
+struct ThreadArenas {
+    FrameArena frame{FRAME_ARENA_BYTES};
+    std::array<FrameArena, 2> double_buffered{FrameArena(FRAME_ARENA_BYTES), FrameArena(FRAME_ARENA_BYTES)};
+};
+
+// arenas live until exit, endFrame resets the ones of threads that have ended too
+std::mutex arenas_mutex;
+std::vector<std::unique_ptr<ThreadArenas>> arenas;
+thread_local ThreadArenas* local_arenas = nullptr;
+// which half of every pair the current frame allocates from
+std::atomic<size_t> double_buffer_index{0};
+
+ThreadArenas& localArenas() {
+    if (local_arenas == nullptr) {
+        std::lock_guard<std::mutex> lock(arenas_mutex);
+        arenas.push_back(std::make_unique<ThreadArenas>());
+        local_arenas = arenas.back().get();
+    }
+    return *local_arenas;
+}
+
+}  // namespace
+
+FrameArena::FrameArena(size_t capacity) : size(capacity) {}
+
+FrameArena::~FrameArena() {
+    ::operator delete(memory);
+}
+
+bool FrameArena::owns(const void* pointer) const {
+    const char* bytes = static_cast<const char*>(pointer);
+    return memory != nullptr && bytes >= memory && bytes < memory + size;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    assert(alignment <= alignof(std::max_align_t));
+    if (memory == nullptr) memory = static_cast<char*>(::operator new(size));
+
+    size_t start = (offset + alignment - 1) & ~(alignment - 1);
+    if (start + bytes > size) {
+        if (!warned) {
+            std::cerr << "WARNING: Frame arena of " << size << " bytes is full, FRAME_ARENA_BYTES is too small"
+                      << std::endl;
+            warned = true;
+        }
+        return ::operator new(bytes);
+    }
+    offset = start + bytes;
+    high_water = std::max(high_water, offset);
+    return memory + start;
+}
+
+void FrameArena::deallocate(void* pointer, size_t bytes) {
+    if (pointer == nullptr) return;
+    if (!owns(pointer)) {
+        ::operator delete(pointer);
+        return;
+    }
+    // a read after free sees the poison instead of stale data
+#ifdef BNUUY_ARENA_POISON_ENABLED
+    std::memset(pointer, poison_byte, bytes);
+#endif
+    // only a last-in first-out free comes straight back, e.g. a scratch vector destroyed before anything
+    // else was allocated. A growing vector frees its old block after allocating the new one, so that
+    // block is never the most recent and waits for reset like the rest.
+    if (static_cast<char*>(pointer) + bytes == memory + offset) offset -= bytes;
+}
+
+void FrameArena::reset() {
+#ifdef BNUUY_ARENA_POISON_ENABLED
+    if (memory != nullptr) std::memset(memory, poison_byte, offset);
+#endif
+    offset = 0;
+}
+
+FrameArena& FrameArena::frame() {
+    return localArenas().frame;
+}
+
+FrameArena& FrameArena::doubleBuffered() {
+    return localArenas().double_buffered[double_buffer_index.load(std::memory_order_relaxed)];
+}
+
+void FrameArena::endFrame() {
+    // the half the next frame allocates from was last used two frames ago
+    size_t next_index = 1 - double_buffer_index.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(arenas_mutex);
+    for (const std::unique_ptr<ThreadArenas>& thread_arenas : arenas) {
+        thread_arenas->frame.reset();
+        thread_arenas->double_buffered[next_index].reset();
+    }
+    double_buffer_index.store(next_index, std::memory_order_relaxed);
+}
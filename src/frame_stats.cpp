@@ -0,0 +1,231 @@
+#include "frame_stats.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#include "common.hpp"
+#include "tinyECS/registry.hpp"
+
+namespace {
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// nearest rank on a scratch copy, nth_element leaves it partially sorted
+float percentile(std::vector<float>& values, float fraction) {
+    size_t rank = std::min(values.size() - 1, (size_t) (fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+}  // namespace
+
+FrameStats& FrameStats::getInstance() {
+    static FrameStats instance;
+    return instance;
+}
+
+FrameStats::FrameStats() {
+    container_count = registry.container_count();
+    samples.resize(FRAME_STATS_HISTORY);
+    entity_counts.resize(FRAME_STATS_HISTORY * container_count);
+    scratch.reserve(FRAME_STATS_HISTORY);
+    last_allocations = allocationTotals();
+    for (int zone = 0; zone < allocation_zone_count; zone++) last_zone_allocations[zone] = allocationTotals(zone);
+}
+
+void FrameStats::endFrame(FrameSample sample) {
+    AllocationTotals allocations = allocationTotals();
+    sample.frame = frames_recorded++;
+    sample.allocations = (uint32_t) (allocations.allocations - last_allocations.allocations);
+    sample.allocated_bytes = allocations.bytes - last_allocations.bytes;
+    last_allocations = allocations;
+
+    auto takeZone = [&](int zone, uint32_t& zone_allocations, uint64_t& zone_bytes) {
+        AllocationTotals totals = allocationTotals(zone);
+        zone_allocations = (uint32_t) (totals.allocations - last_zone_allocations[zone].allocations);
+        zone_bytes = totals.bytes - last_zone_allocations[zone].bytes;
+        last_zone_allocations[zone] = totals;
+    };
+    for (int i = 0; i < sim_system_count; i++) {
+        takeZone(systemAllocationZone((SIM_SYSTEM) i), sample.system_allocations[i], sample.system_allocated_bytes[i]);
+    }
+    takeZone(render_allocation_zone, sample.render_allocations, sample.render_allocated_bytes);
+
+    samples[next] = sample;
+    for (size_t i = 0; i < container_count; i++) {
+        entity_counts[next * container_count + i] = (uint32_t) registry.container_size(i);
+    }
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+}
+
+FrameTimeSummary FrameStats::summarizeScratch() const {
+    FrameTimeSummary summary;
+    if (scratch.empty()) return summary;
+    summary.max = *std::max_element(scratch.begin(), scratch.end());
+    summary.p99 = percentile(scratch, 0.99f);
+    summary.p95 = percentile(scratch, 0.95f);
+    summary.p50 = percentile(scratch, 0.50f);
+    return summary;
+}
+
+FrameTimeSummary FrameStats::summarize(float FrameSample::*metric) const {
+    scratch.clear();
+    for (size_t age = 0; age < count; age++) scratch.push_back(frame(age).*metric);
+    return summarizeScratch();
+}
+
+FrameTimeSummary FrameStats::summarizeSystem(SIM_SYSTEM system) const {
+    scratch.clear();
+    for (size_t age = 0; age < count; age++) scratch.push_back(frame(age).system_ms[(int) system]);
+    return summarizeScratch();
+}
+
+FrameTimeSummary FrameStats::summarizeGpuPass(GPU_PASS pass) const {
+    scratch.clear();
+    for (size_t age = 0; age < count; age++) scratch.push_back(frame(age).gpu_pass_ms[(int) pass]);
+    return summarizeScratch();
+}
+
+bool FrameStats::exportFile(const std::string& path) const {
+    return endsWith(path, ".json") ? exportJSON(path) : exportCSV(path);
+}
+
+bool FrameStats::exportCSV(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "ERROR: Could not write frame statistics " << path << std::endl;
+        return false;
+    }
+
+    fprintf(file, "frame,frame_ms,update_ms,render_ms");
+    for (const char* name : sim_system_names) fprintf(file, ",%s_ms", name);
+    fprintf(file, ",gpu_ms");
+    for (const char* name : gpu_pass_names) fprintf(file, ",gpu_%s_ms", name);
+    fprintf(file, ",draw_calls,sprites,gl_calls_issued,gl_calls_elided,allocations,allocated_bytes");
+    for (const char* name : sim_system_names) fprintf(file, ",%s_allocations,%s_bytes", name, name);
+    fprintf(file, ",render_allocations,render_bytes");
+    for (size_t i = 0; i < container_count; i++) fprintf(file, ",%s", registry.container_name(i));
+    fprintf(file, "\n");
+
+    // oldest first
+    for (size_t age = count; age-- > 0;) {
+        const FrameSample& sample = frame(age);
+        fprintf(file,
+                "%llu,%.3f,%.3f,%.3f",
+                (unsigned long long) sample.frame,
+                sample.frame_ms,
+                sample.update_ms,
+                sample.render_ms);
+        for (float ms : sample.system_ms) fprintf(file, ",%.3f", ms);
+        fprintf(file, ",%.3f", sample.gpu_ms);
+        for (float ms : sample.gpu_pass_ms) fprintf(file, ",%.3f", ms);
+        fprintf(file,
+                ",%d,%d,%d,%d,%u,%llu",
+                sample.draw_calls,
+                sample.sprites,
+                sample.gl_calls_issued,
+                sample.gl_calls_elided,
+                sample.allocations,
+                (unsigned long long) sample.allocated_bytes);
+        for (int i = 0; i < sim_system_count; i++) {
+            fprintf(file,
+                    ",%u,%llu",
+                    sample.system_allocations[i],
+                    (unsigned long long) sample.system_allocated_bytes[i]);
+        }
+        fprintf(file, ",%u,%llu", sample.render_allocations, (unsigned long long) sample.render_allocated_bytes);
+        for (size_t i = 0; i < container_count; i++) fprintf(file, ",%u", entityCount(age, i));
+        fprintf(file, "\n");
+    }
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    printf("Wrote %zu frames of statistics to %s\n", count, path.c_str());
+    return ok;
+}
+
+bool FrameStats::exportJSON(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "ERROR: Could not write frame statistics " << path << std::endl;
+        return false;
+    }
+
+    auto writeSummary = [&](const char* name, const FrameTimeSummary& summary, bool last) {
+        fprintf(file,
+                "    \"%s\": {\"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}%s\n",
+                name,
+                summary.p50,
+                summary.p95,
+                summary.p99,
+                summary.max,
+                last ? "" : ",");
+    };
+
+    fprintf(file, "{\n  \"summary\": {\n");
+    writeSummary("frame_ms", summarize(&FrameSample::frame_ms), false);
+    writeSummary("update_ms", summarize(&FrameSample::update_ms), false);
+    writeSummary("render_ms", summarize(&FrameSample::render_ms), false);
+    for (int i = 0; i < sim_system_count; i++) {
+        std::string name = std::string(sim_system_names[i]) + "_ms";
+        writeSummary(name.c_str(), summarizeSystem((SIM_SYSTEM) i), false);
+    }
+    writeSummary("gpu_ms", summarize(&FrameSample::gpu_ms), false);
+    for (int i = 0; i < gpu_pass_count; i++) {
+        std::string name = "gpu_" + std::string(gpu_pass_names[i]) + "_ms";
+        writeSummary(name.c_str(), summarizeGpuPass((GPU_PASS) i), i == gpu_pass_count - 1);
+    }
+    fprintf(file, "  },\n  \"frames\": [\n");
+
+    for (size_t age = count; age-- > 0;) {
+        const FrameSample& sample = frame(age);
+        fprintf(file,
+                "    {\"frame\": %llu, \"frame_ms\": %.3f, \"update_ms\": %.3f, \"render_ms\": %.3f, \"systems_ms\": {",
+                (unsigned long long) sample.frame,
+                sample.frame_ms,
+                sample.update_ms,
+                sample.render_ms);
+        for (int i = 0; i < sim_system_count; i++) {
+            fprintf(file, "%s\"%s\": %.3f", i == 0 ? "" : ", ", sim_system_names[i], sample.system_ms[i]);
+        }
+        fprintf(file, "}, \"gpu_ms\": %.3f, \"gpu_passes_ms\": {", sample.gpu_ms);
+        for (int i = 0; i < gpu_pass_count; i++) {
+            fprintf(file, "%s\"%s\": %.3f", i == 0 ? "" : ", ", gpu_pass_names[i], sample.gpu_pass_ms[i]);
+        }
+        fprintf(file,
+                "}, \"draw_calls\": %d, \"sprites\": %d, \"gl_calls_issued\": %d, \"gl_calls_elided\": %d, "
+                "\"allocations\": %u, \"allocated_bytes\": %llu, \"allocations_by_zone\": {",
+                sample.draw_calls,
+                sample.sprites,
+                sample.gl_calls_issued,
+                sample.gl_calls_elided,
+                sample.allocations,
+                (unsigned long long) sample.allocated_bytes);
+        for (int i = 0; i < sim_system_count; i++) {
+            fprintf(file,
+                    "\"%s\": [%u, %llu], ",
+                    sim_system_names[i],
+                    sample.system_allocations[i],
+                    (unsigned long long) sample.system_allocated_bytes[i]);
+        }
+        fprintf(file,
+                "\"render\": [%u, %llu]}, \"entities\": {",
+                sample.render_allocations,
+                (unsigned long long) sample.render_allocated_bytes);
+        for (size_t i = 0; i < container_count; i++) {
+            fprintf(file, "%s\"%s\": %u", i == 0 ? "" : ", ", registry.container_name(i), entityCount(age, i));
+        }
+        fprintf(file, "}}%s\n", age == 0 ? "" : ",");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    printf("Wrote %zu frames of statistics to %s\n", count, path.c_str());
+    return ok;
+}
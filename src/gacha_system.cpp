@@ -8,6 +8,7 @@
 #include "gacha_system.hpp"
 #include "sceneManager/scene_manager.hpp"
 #include "render_system.hpp"
+#include "rng.hpp"
 
 GachaSystem& GachaSystem::getInstance() {
     static GachaSystem instance;
@@ -16,7 +17,6 @@ GachaSystem& GachaSystem::getInstance() {
 
 // Private constructor
 GachaSystem::GachaSystem() {
-    rng.seed(static_cast<unsigned>(time(nullptr)));
     levelModulePools.resize(5); // Set to 5 levels for now
     
     // Dayshaun: put level pool loading in each level.cpp file
@@ -74,7 +74,7 @@ std::vector<MODULE_TYPES> GachaSystem::getModuleOptions(int level){
     std::discrete_distribution<int> distribution(weights.begin(), weights.end());
 
     for (int i = 0; i < numOptions; ++i) {
-        int index = distribution(rng);
+        int index = distribution(RngService::getInstance().stream(RNG_STREAM::GACHA));
         selectedModules.push_back(availableModules[index]);
     }
 
@@ -0,0 +1,62 @@
+#include "gl_state.hpp"
+
+bool GLStateTracker::changed(GLuint& current, GLuint value) {
+    if (current == value) {
+        elided++;
+        return false;
+    }
+    current = value;
+    issued++;
+    return true;
+}
+
+void GLStateTracker::useProgram(GLuint value) {
+    if (changed(program, value)) glUseProgram(value);
+}
+
+void GLStateTracker::bindVertexArray(GLuint value) {
+    if (changed(vao, value)) glBindVertexArray(value);
+}
+
+void GLStateTracker::bindArrayBuffer(GLuint value) {
+    if (changed(array_buffer, value)) glBindBuffer(GL_ARRAY_BUFFER, value);
+}
+
+void GLStateTracker::activeTexture(GLenum unit) {
+    if (changed(active_unit, unit)) glActiveTexture(unit);
+}
+
+void GLStateTracker::bindTexture2D(GLuint texture) {
+    GLuint unit = active_unit == UNKNOWN ? UNKNOWN : active_unit - GL_TEXTURE0;
+    if (unit >= TRACKED_TEXTURE_UNITS) {
+        issued++;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+    if (changed(textures[unit], texture)) glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLStateTracker::texParameter(GLuint texture, GLenum pname, GLint value) {
+    uint64_t key = ((uint64_t) texture << 32) | pname;
+    auto it = tex_parameters.find(key);
+    if (it != tex_parameters.end() && it->second == value) {
+        elided++;
+        return;
+    }
+    tex_parameters[key] = value;
+    issued++;
+    glTexParameteri(GL_TEXTURE_2D, pname, value);
+}
+
+void GLStateTracker::invalidate() {
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    array_buffer = UNKNOWN;
+    active_unit = UNKNOWN;
+    textures.fill(UNKNOWN);
+}
+
+void GLStateTracker::resetCounters() {
+    issued = 0;
+    elided = 0;
+}
@@ -0,0 +1,56 @@
+#include "gpu_timer.hpp"
+
+// stlib
+#include <iostream>
+
+void GpuPassTimer::init() {
+    GLint counter_bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+    enabled = counter_bits > 0;
+    if (!enabled) {
+        std::cout << "GPU pass timing is off, the context has no timestamp counter" << std::endl;
+        return;
+    }
+    for (auto& set : queries) glGenQueries((GLsizei) set.size(), set.data());
+    in_flight.fill(false);
+    gl_has_errors();
+}
+
+void GpuPassTimer::destroy() {
+    if (!enabled) return;
+    for (auto& set : queries) glDeleteQueries((GLsizei) set.size(), set.data());
+    enabled = false;
+}
+
+void GpuPassTimer::beginFrame() {
+    if (!enabled) return;
+
+    auto& set = queries[current];
+    if (in_flight[current]) {
+        // the last stamp lands last, once it is available the whole set is
+        GLint available = 0;
+        glGetQueryObjectiv(set[gpu_pass_count], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            std::array<GLuint64, gpu_pass_count + 1> stamps;
+            for (size_t i = 0; i < stamps.size(); i++) glGetQueryObjectui64v(set[i], GL_QUERY_RESULT, &stamps[i]);
+            for (int i = 0; i < gpu_pass_count; i++) pass_ms[i] = (float) (stamps[i + 1] - stamps[i]) / 1e6f;
+            total_ms = (float) (stamps[gpu_pass_count] - stamps[0]) / 1e6f;
+        }
+        // not ready means the GPU is more than GPU_TIMER_FRAMES behind, that frame's times are dropped
+        // instead of waiting; stamping the queries again below simply restarts them
+        in_flight[current] = false;
+    }
+    glQueryCounter(set[0], GL_TIMESTAMP);
+}
+
+void GpuPassTimer::endPass(GPU_PASS pass) {
+    if (!enabled) return;
+    glQueryCounter(queries[current][(int) pass + 1], GL_TIMESTAMP);
+}
+
+void GpuPassTimer::endFrame() {
+    if (!enabled) return;
+    in_flight[current] = true;
+    current = (current + 1) % queries.size();
+    gl_has_errors();
+}
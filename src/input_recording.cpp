@@ -0,0 +1,113 @@
+#include "input_recording.hpp"
+#include "world_system.hpp"
+
+// stlib
+#include <cassert>
+#include <iostream>
+
+namespace {
+
+const uint32_t input_log_magic = 0x43455242;  // "BREC"
+const uint32_t input_log_version = 1;
+
+template <typename T>
+void writeValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+    return (bool) file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+bool InputRecorder::open(const std::string& path, uint32_t seed) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "ERROR: Could not write input log " << path << std::endl;
+        return false;
+    }
+    writeValue(file, input_log_magic);
+    writeValue(file, input_log_version);
+    writeValue(file, seed);
+    tick_events.clear();
+    ticks = 0;
+    return true;
+}
+
+void InputRecorder::close() {
+    if (file.is_open()) file.close();
+}
+
+void InputRecorder::record(const InputEvent& event) {
+    if (file.is_open()) tick_events.push_back(event);
+}
+
+void InputRecorder::endTick(float elapsed_ms) {
+    if (!file.is_open()) return;
+
+    assert(tick_events.size() <= UINT16_MAX);
+    writeValue(file, elapsed_ms);
+    writeValue(file, (uint16_t) tick_events.size());
+    for (const InputEvent& event : tick_events) {
+        writeValue(file, (uint8_t) event.type);
+        if (event.type == INPUT_EVENT_TYPE::MOUSE_MOVE) {
+            writeValue(file, event.position.x);
+            writeValue(file, event.position.y);
+        } else {
+            writeValue(file, (int16_t) event.key_or_button);
+            writeValue(file, (uint8_t) event.action);
+            writeValue(file, (uint8_t) event.mods);
+        }
+    }
+    ticks++;
+    tick_events.clear();
+}
+
+bool InputReplay::open(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR: Could not open input log " << path << std::endl;
+        return false;
+    }
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!readValue(file, magic) || !readValue(file, version) || !readValue(file, seed) ||
+        magic != input_log_magic || version != input_log_version) {
+        std::cerr << "ERROR: " << path << " is not an input log of version " << input_log_version << std::endl;
+        file.close();
+        return false;
+    }
+    ticks = 0;
+    return true;
+}
+
+bool InputReplay::nextTick(WorldSystem& world_system, float& elapsed_ms) {
+    uint16_t count = 0;
+    if (!file.is_open() || !readValue(file, elapsed_ms) || !readValue(file, count)) return false;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t type = 0;
+        if (!readValue(file, type)) return false;
+
+        if ((INPUT_EVENT_TYPE) type == INPUT_EVENT_TYPE::MOUSE_MOVE) {
+            vec2 position;
+            if (!readValue(file, position.x) || !readValue(file, position.y)) return false;
+            world_system.on_mouse_move(position);
+            continue;
+        }
+
+        int16_t key_or_button = 0;
+        uint8_t action = 0;
+        uint8_t mods = 0;
+        if (!readValue(file, key_or_button) || !readValue(file, action) || !readValue(file, mods)) return false;
+        if ((INPUT_EVENT_TYPE) type == INPUT_EVENT_TYPE::KEY) {
+            world_system.on_key(key_or_button, 0, action, mods);
+        } else {
+            world_system.on_mouse_button_pressed(key_or_button, action, mods);
+        }
+    }
+    ticks++;
+    return true;
+}
@@ -19,6 +19,7 @@
 
 // stdlib
 #include <chrono>
+#include <cstring>
 #include <iostream>
 
 // internal
@@ -26,13 +27,102 @@
 #include "world_system.hpp"
 #include "animation_system.hpp"
 #include "sound_system.hpp"
+#include "rng.hpp"
+#include "frame_arena.hpp"
+#include "frame_stats.hpp"
+#include "input_recording.hpp"
+#include "perf_hud.hpp"
+#include "profiler.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
+// Command line options
+//   --backend=window|headless|null  headless and null need no display, see render_backend.hpp
+//   --frames=N                      quit after N frames, stepped with a fixed 1/60 s when headless
+//   --dump=<dir>                    write every drawn frame to <dir>/frame_NNNNN.png
+//   --seed=S                        session seed, random by default
+//   --record=<file>                 log every frame's input and elapsed time, see input_recording.hpp
+//   --replay=<file>                 play a log back as fast as the backend allows, live input is ignored
+//   --trace=<file>                  write a Chrome trace of every profile zone from startup to exit
+//   --stats=<file>                  write the last minute of frame statistics at exit, .json or .csv;
+//                                   F9 writes them at any time, to frame_stats.csv by default
+// F3 toggles the performance overlay, see perf_hud.hpp
+struct LaunchOptions {
+    RENDER_BACKEND backend = RENDER_BACKEND::WINDOW;
+    int frames = 0;
+    std::string dump_dir;
+    bool has_seed = false;
+    uint32_t seed = 0;
+    std::string record_path;
+    std::string replay_path;
+    std::string trace_path;
+    std::string stats_path;
+};
+
+bool parseLaunchOptions(int argc, char* argv[], LaunchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--backend=", 10) == 0) {
+            if (!parseRenderBackend(arg + 10, options.backend)) {
+                std::cerr << "ERROR: Unknown backend " << (arg + 10) << ", expected window, headless or null"
+                          << std::endl;
+                return false;
+            }
+        } else if (std::strncmp(arg, "--frames=", 9) == 0) {
+            options.frames = std::atoi(arg + 9);
+        } else if (std::strncmp(arg, "--dump=", 7) == 0) {
+            options.dump_dir = arg + 7;
+        } else if (std::strncmp(arg, "--seed=", 7) == 0) {
+            options.has_seed = true;
+            options.seed = (uint32_t) std::strtoul(arg + 7, nullptr, 10);
+        } else if (std::strncmp(arg, "--record=", 9) == 0) {
+            options.record_path = arg + 9;
+        } else if (std::strncmp(arg, "--replay=", 9) == 0) {
+            options.replay_path = arg + 9;
+        } else if (std::strncmp(arg, "--trace=", 8) == 0) {
+            options.trace_path = arg + 8;
+        } else if (std::strncmp(arg, "--stats=", 8) == 0) {
+            options.stats_path = arg + 8;
+        } else {
+            std::cerr << "ERROR: Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 // Entry point
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << "Working dir: " << std::filesystem::current_path() << "\n";
 
+    LaunchOptions options;
+    if (!parseLaunchOptions(argc, argv, options)) return EXIT_FAILURE;
+    Profiler::nameThread("main");
+    if (!options.trace_path.empty()) {
+#ifdef BNUUY_PROFILE_ENABLED
+        Profiler::start();
+#else
+        std::cerr << "WARNING: profile zones are compiled out, build without NDEBUG or with BNUUY_PROFILE" << std::endl;
+#endif
+    }
+    bool headless = options.backend != RENDER_BACKEND::WINDOW;
+    if (!options.dump_dir.empty()) std::filesystem::create_directories(options.dump_dir);
+
+    // a replay brings its own seed
+    InputReplay replay;
+    bool replaying = !options.replay_path.empty();
+    if (replaying && !replay.open(options.replay_path)) return EXIT_FAILURE;
+    RngService& rng_service = RngService::getInstance();
+    uint32_t seed = replaying ? replay.getSeed() : options.has_seed ? options.seed : rng_service.getSeed();
+    std::cout << "Session seed: " << seed << std::endl;
+    rng_service.seed(seed);
+
+    InputRecorder recorder;
+    if (!options.record_path.empty() && !recorder.open(options.record_path, seed)) return EXIT_FAILURE;
+
+    FrameStats& frame_stats = FrameStats::getInstance();
+    if (!options.stats_path.empty()) frame_stats.setExportPath(options.stats_path);
+
     // global systems
     WorldSystem world_system;
     RenderSystem renderer_system;
@@ -42,9 +132,9 @@ int main() {
     float msCounter = 0;
 
     // initialize window
-    GLFWwindow* window = world_system.create_window();
+    GLFWwindow* window = headless ? nullptr : world_system.create_window();
 
-    if (!window) {
+    if (!window && !headless) {
         // Time to read the error message
         std::cerr << "ERROR: Failed to create window.  Press any key to exit" << std::endl;
         getchar();
@@ -54,10 +144,15 @@ int main() {
     //if (!world_system.start_and_load_sounds()) std::cerr << "ERROR: Failed to start or load sounds." << std::endl;
 
     // initialize the main systems
-    renderer_system.init(window);
+    if (!renderer_system.init(window, options.backend)) {
+        std::cerr << "ERROR: Failed to initialize the renderer" << std::endl;
+        return EXIT_FAILURE;
+    }
     renderer_system.fontInit(font_path("sproutslandfont.ttf"), 16);
     world_system.init(&renderer_system);
     sound_system.init();
+    if (recorder.isOpen()) world_system.setInputRecorder(&recorder);
+    if (replaying) world_system.setLiveInput(false);
 
     // variable timestep loop
     auto t = Clock::now();
@@ -92,12 +187,22 @@ int main() {
 
     scene_manager.switchScene("IntroCutscene");
 
+    int frame = 0;
+    size_t gl_calls_recorded = 0;
+    auto run_start = Clock::now();
     while (!world_system.is_over()) {
-        glfwPollEvents();
+        PROFILE_ZONE("frame");
+        auto frame_start = Clock::now();
+        if (!headless) glfwPollEvents();
 
         auto now = Clock::now();
         float elapsed_ms = (float) (std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
         t = now;
+        // a fixed step makes headless runs reproducible frame for frame
+        if (headless) elapsed_ms = 1000.f / 60.f;
+        // replays take both the input and the elapsed time from the log
+        if (replaying && !replay.nextTick(world_system, elapsed_ms)) break;
+        recorder.endTick(elapsed_ms);
         
         msCounter += elapsed_ms;
         // std::cout << "msCounter: " << msCounter << std::endl;
@@ -105,18 +210,75 @@ int main() {
         // std::cout << frameCounter << std::endl;
         if(msCounter >= 1000){
             world_system.fpsCounter = frameCounter* (msCounter/1000.f);
+            world_system.refresh_title();
             
             msCounter = 0;
             frameCounter = 0;
         }
         // std::cout << "FPS: " << world_system.fpsCounter << std::endl;
+        auto update_start = Clock::now();
         scene_manager.checkSceneSwitch();
         Scene* s = scene_manager.getCurrentScene();
         if (s != nullptr) s->Update(elapsed_ms);
-        world_system.step(elapsed_ms);
+        {
+            PROFILE_ZONE("world.step");
+            world_system.step(elapsed_ms);
+        }
+        auto update_end = Clock::now();
+        if (!options.dump_dir.empty()) {
+            char filename[32];
+            snprintf(filename, sizeof(filename), "/frame_%05d.png", frame);
+            renderer_system.requestFrameDump(options.dump_dir + filename);
+        }
         renderer_system.draw();
-        sound_system.play();
+        {
+            PROFILE_ZONE("sound.play");
+            sound_system.play();
+        }
+        if (options.backend == RENDER_BACKEND::NULL_GL) {
+            gl_calls_recorded += nullGLCommands().size();
+            clearNullGLCommands();
+        }
+
+        FrameSample sample;
+        // the level's systems add up over the frame, take them and start the next frame from zero
+        SystemTimings* timings = s != nullptr ? s->getSystemTimings() : nullptr;
+        if (timings != nullptr) {
+            for (int i = 0; i < sim_system_count; i++) sample.system_ms[i] = (float) timings->ms[i];
+            timings->reset();
+        }
+        const RenderStats& render_stats = renderer_system.getFrameStats();
+        sample.update_ms =
+            (float) (std::chrono::duration_cast<std::chrono::microseconds>(update_end - update_start)).count() / 1000;
+        sample.render_ms = render_stats.cpu_ms;
+        sample.gpu_ms = renderer_system.getGpuTimer().getTotalMs();
+        sample.gpu_pass_ms = renderer_system.getGpuTimer().getPassMs();
+        sample.draw_calls = render_stats.draw_calls;
+        sample.sprites = render_stats.sprites;
+        sample.gl_calls_issued = render_stats.gl_calls_issued;
+        sample.gl_calls_elided = render_stats.gl_calls_elided;
+        sample.frame_ms =
+            (float) (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - frame_start)).count() / 1000;
+        frame_stats.endFrame(sample);
+        PerfHud::getInstance().update(elapsed_ms);
+        // nothing transient outlives the iteration, the physics workers are idle between steps
+        FrameArena::endFrame();
         
+        frame++;
+        if (options.frames > 0 && frame >= options.frames) world_system.close_window();
+    }
+
+    recorder.close();
+    if (!options.stats_path.empty()) frame_stats.exportFile(options.stats_path);
+    if (!options.trace_path.empty() && Profiler::isCapturing()) Profiler::writeChromeTrace(options.trace_path);
+    if (replaying) printf("replayed %u frames\n", replay.tickCount());
+    if (headless) {
+        float run_ms =
+            (float) (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - run_start)).count() / 1000;
+        printf("%d frames in %.1f ms (%.3f ms/frame)\n", frame, run_ms, frame > 0 ? run_ms / frame : 0.f);
+        if (options.backend == RENDER_BACKEND::NULL_GL) {
+            printf("null backend recorded %zu GL calls\n", gl_calls_recorded);
+        }
     }
 
     delete mm;
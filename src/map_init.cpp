@@ -2,6 +2,7 @@
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
 #include "tinyECS/entity.hpp"
+#include "profiler.hpp"
 #include "../ext/tileson/tileson.hpp"
 #include <iostream>
 #include <filesystem>
@@ -105,6 +106,7 @@ void debugMap(std::unique_ptr<tson::Map>& map) {
  *	- return map size as tson::Vector2<int>
  */
 std::pair<tson::Vector2i, tson::Vector2i> loadMap(const std::string& name) {
+    PROFILE_ZONE("map.load");
     // delete stuff from previous maps
     registry.enemies.clear();
     registry.islands.clear();
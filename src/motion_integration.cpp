@@ -0,0 +1,34 @@
+#include "motion_integration.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+void integrateSoA(float* x, float* y, const float* vx, const float* vy, size_t n, float step_seconds) {
+    size_t i = 0;
+#if defined(__AVX__)
+    const __m256 dt8 = _mm256_set1_ps(step_seconds);
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), dt8)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), dt8)));
+    }
+#endif
+#if defined(__SSE__) || defined(_M_X64)
+    const __m128 dt4 = _mm_set1_ps(step_seconds);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), dt4)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), dt4)));
+    }
+#endif
+    // scalar tail (and the whole range on non-x86 builds)
+    for (; i < n; i++) {
+        x[i] += vx[i] * step_seconds;
+        y[i] += vy[i] * step_seconds;
+    }
+}
+
+void integrateMotions(ComponentContainer<Motion>& motions, float step_seconds) {
+    for (Motion& motion : motions.components) {
+        motion.position += motion.velocity * step_seconds;
+    }
+}
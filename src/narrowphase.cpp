@@ -0,0 +1,135 @@
+#include "narrowphase.hpp"
+
+// stlib
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define NARROWPHASE_SSE 1
+#endif
+
+void CirclePairs::clear() {
+    first.clear();
+    second.clear();
+    ax.clear();
+    ay.clear();
+    bx.clear();
+    by.clear();
+    a_r_squared.clear();
+    b_r_squared.clear();
+}
+
+void CirclePairs::push(uint32_t i, uint32_t j, vec2 a, float a_r_sq, vec2 b, float b_r_sq) {
+    first.push_back(i);
+    second.push_back(j);
+    ax.push_back(a.x);
+    ay.push_back(a.y);
+    bx.push_back(b.x);
+    by.push_back(b.y);
+    a_r_squared.push_back(a_r_sq);
+    b_r_squared.push_back(b_r_sq);
+}
+
+void BoxPairs::clear() {
+    first.clear();
+    second.clear();
+    ax.clear();
+    ay.clear();
+    a_half_w.clear();
+    a_half_h.clear();
+    bx.clear();
+    by.clear();
+    b_half_w.clear();
+    b_half_h.clear();
+}
+
+void BoxPairs::push(uint32_t i, uint32_t j, vec2 a, vec2 a_half, vec2 b, vec2 b_half) {
+    first.push_back(i);
+    second.push_back(j);
+    ax.push_back(a.x);
+    ay.push_back(a.y);
+    a_half_w.push_back(a_half.x);
+    a_half_h.push_back(a_half.y);
+    bx.push_back(b.x);
+    by.push_back(b.y);
+    b_half_w.push_back(b_half.x);
+    b_half_h.push_back(b_half.y);
+}
+
+namespace {
+// append base + the set bits of mask, lowest first so the hit list stays in pair order
+inline void appendHits(unsigned int mask, size_t base, std::vector<uint32_t>& hits) {
+    while (mask) {
+        unsigned int bit = 0;
+        while (!(mask & (1u << bit))) bit++;
+        hits.push_back((uint32_t) (base + bit));
+        mask &= mask - 1;
+    }
+}
+
+inline bool circleHit(const CirclePairs& p, size_t k) {
+    float dx = p.ax[k] - p.bx[k];
+    float dy = p.ay[k] - p.by[k];
+    return dx * dx + dy * dy < std::max(p.a_r_squared[k], p.b_r_squared[k]);
+}
+
+// separated when one box ends strictly before the other starts, same as the old collidesAABBMot
+inline bool boxHit(const BoxPairs& p, size_t k) {
+    if (p.ax[k] + p.a_half_w[k] < p.bx[k] - p.b_half_w[k] || p.bx[k] + p.b_half_w[k] < p.ax[k] - p.a_half_w[k])
+        return false;
+    if (p.ay[k] + p.a_half_h[k] < p.by[k] - p.b_half_h[k] || p.by[k] + p.b_half_h[k] < p.ay[k] - p.a_half_h[k])
+        return false;
+    return true;
+}
+}  // namespace
+
+void narrowphaseCircles(const CirclePairs& pairs, size_t begin, size_t end, std::vector<uint32_t>& hits) {
+    size_t k = begin;
+#if defined(__AVX__)
+    for (; k + 8 <= end; k += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&pairs.ax[k]), _mm256_loadu_ps(&pairs.bx[k]));
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&pairs.ay[k]), _mm256_loadu_ps(&pairs.by[k]));
+        __m256 dist_sq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 r_sq = _mm256_max_ps(_mm256_loadu_ps(&pairs.a_r_squared[k]), _mm256_loadu_ps(&pairs.b_r_squared[k]));
+        appendHits((unsigned int) _mm256_movemask_ps(_mm256_cmp_ps(dist_sq, r_sq, _CMP_LT_OQ)), k, hits);
+    }
+#endif
+#if defined(NARROWPHASE_SSE)
+    for (; k + 4 <= end; k += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&pairs.ax[k]), _mm_loadu_ps(&pairs.bx[k]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&pairs.ay[k]), _mm_loadu_ps(&pairs.by[k]));
+        __m128 dist_sq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 r_sq = _mm_max_ps(_mm_loadu_ps(&pairs.a_r_squared[k]), _mm_loadu_ps(&pairs.b_r_squared[k]));
+        appendHits((unsigned int) _mm_movemask_ps(_mm_cmplt_ps(dist_sq, r_sq)), k, hits);
+    }
+#endif
+    for (; k < end; k++) {
+        if (circleHit(pairs, k)) hits.push_back((uint32_t) k);
+    }
+}
+
+void narrowphaseBoxes(const BoxPairs& pairs, size_t begin, size_t end, std::vector<uint32_t>& hits) {
+    size_t k = begin;
+#if defined(NARROWPHASE_SSE)
+    for (; k + 4 <= end; k += 4) {
+        __m128 ax = _mm_loadu_ps(&pairs.ax[k]);
+        __m128 ay = _mm_loadu_ps(&pairs.ay[k]);
+        __m128 bx = _mm_loadu_ps(&pairs.bx[k]);
+        __m128 by = _mm_loadu_ps(&pairs.by[k]);
+        __m128 a_hw = _mm_loadu_ps(&pairs.a_half_w[k]);
+        __m128 a_hh = _mm_loadu_ps(&pairs.a_half_h[k]);
+        __m128 b_hw = _mm_loadu_ps(&pairs.b_half_w[k]);
+        __m128 b_hh = _mm_loadu_ps(&pairs.b_half_h[k]);
+
+        // overlapping on an axis: neither box ends before the other starts
+        __m128 x_overlap = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(ax, a_hw), _mm_sub_ps(bx, b_hw)),
+                                      _mm_cmpge_ps(_mm_add_ps(bx, b_hw), _mm_sub_ps(ax, a_hw)));
+        __m128 y_overlap = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(ay, a_hh), _mm_sub_ps(by, b_hh)),
+                                      _mm_cmpge_ps(_mm_add_ps(by, b_hh), _mm_sub_ps(ay, a_hh)));
+        appendHits((unsigned int) _mm_movemask_ps(_mm_and_ps(x_overlap, y_overlap)), k, hits);
+    }
+#endif
+    for (; k < end; k++) {
+        if (boxHit(pairs, k)) hits.push_back((uint32_t) k);
+    }
+}
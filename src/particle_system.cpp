@@ -1,29 +1,50 @@
 #include "particle_system.hpp"
 #include <cmath>
 #include "common.hpp"
+#include "motion_integration.hpp"
 #include "tinyECS/registry.hpp"
 
-void ParticleSystem::Emit(ParticleEmitter& emitter, float dt) {
-    Particle& particle = emitter.particles[emitter.poolIndex];
-    particle.Active = true;
-    particle.Position = emitter.props.Position + emitter.props.Offset;
-	particle.Rotation = M_PI * 2 * float_distribution(generator);
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-	// Velocity
-	particle.Velocity = emitter.props.Velocity;
-	particle.Velocity.x += emitter.props.VelocityVariation.x * (float_distribution(generator) - 0.5f);
-	particle.Velocity.y += emitter.props.VelocityVariation.y * (float_distribution(generator) - 0.5f);
+void addToAll(float* values, size_t n, float delta) {
+    size_t i = 0;
+#if defined(__AVX__)
+    const __m256 delta8 = _mm256_set1_ps(delta);
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(values + i, _mm256_add_ps(_mm256_loadu_ps(values + i), delta8));
+    }
+#endif
+#if defined(__SSE__) || defined(_M_X64)
+    const __m128 delta4 = _mm_set1_ps(delta);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(values + i, _mm_add_ps(_mm_loadu_ps(values + i), delta4));
+    }
+#endif
+    // scalar tail (and the whole range on non-x86 builds)
+    for (; i < n; i++) {
+        values[i] += delta;
+    }
+}
+
+void ParticleSystem::Emit(ParticleEmitter& emitter, const float* random) {
+    ParticlePool& pool = emitter.particles;
+    // a full pool drops the new particle instead of overwriting a live one
+    if (pool.count == pool.capacity()) return;
+    size_t i = pool.count++;
 
-	// Color
-	particle.ColorBegin = emitter.props.ColorBegin;
-	particle.ColorEnd = emitter.props.ColorEnd;
+    vec2 position = emitter.props.Position + emitter.props.Offset;
+    pool.position_x[i] = position.x;
+    pool.position_y[i] = position.y;
+	pool.rotation[i] = M_PI * 2 * random[0];
 
-	particle.LifeTime = emitter.props.LifeTime;
-	particle.LifeRemaining = emitter.props.LifeTime;
-	particle.SizeBegin = emitter.props.SizeBegin + emitter.props.SizeVariation * (float_distribution(generator) - 0.5f);
-	particle.SizeEnd = emitter.props.SizeEnd;
+	// Velocity
+	pool.velocity_x[i] = emitter.props.Velocity.x + emitter.props.VelocityVariation.x * (random[1] - 0.5f);
+	pool.velocity_y[i] = emitter.props.Velocity.y + emitter.props.VelocityVariation.y * (random[2] - 0.5f);
 
-	emitter.poolIndex = --emitter.poolIndex % emitter.particles.size();
+	pool.life_remaining[i] = emitter.props.LifeTime;
+	pool.size_begin[i] = emitter.props.SizeBegin + emitter.props.SizeVariation * (random[3] - 0.5f);
 }
 
 void ParticleSystem::step(float dt) {
@@ -33,19 +54,30 @@ void ParticleSystem::step(float dt) {
             particle_emitter.props.Position = registry.motions.get(particle_emitter_entity).position;
         }
 
-        for (Particle& particle : particle_emitter.particles) {
-            if (!particle.Active || particle.LifeRemaining <= 0.0f) {
-                particle.Active = false;
-                continue;
+        // only the live range is touched, and every field is updated with the same SIMD kernels
+        ParticlePool& pool = particle_emitter.particles;
+        integrateSoA(pool.position_x.data(),
+                     pool.position_y.data(),
+                     pool.velocity_x.data(),
+                     pool.velocity_y.data(),
+                     pool.count,
+                     dt / 1000.0f);
+        addToAll(pool.rotation.data(), pool.count, 0.01f * dt / 1000.0f);
+        addToAll(pool.life_remaining.data(), pool.count, -dt);
+
+        for (size_t i = 0; i < pool.count;) {
+            if (pool.life_remaining[i] <= 0.0f) {
+                pool.kill(i);
+            } else {
+                i++;
             }
-            particle.LifeRemaining -= dt;
-            particle.Position += particle.Velocity * dt / 1000.0f;
-            particle.Rotation += 0.01 * dt / 1000.0f;
         }
 
         if (particle_emitter.delay_ms <= 0) {
-            for (int i = 0; i < 5; i++)
-                Emit(particle_emitter, dt);
+            float random[PARTICLES_PER_BURST * PARTICLE_RANDOMS_PER_EMIT];
+            random_stream.fillFloats(random, PARTICLES_PER_BURST * PARTICLE_RANDOMS_PER_EMIT);
+            for (int i = 0; i < PARTICLES_PER_BURST; i++)
+                Emit(particle_emitter, random + i * PARTICLE_RANDOMS_PER_EMIT);
             particle_emitter.delay_ms = DEFAULT_PARTICLE_TIME;
         } else {
             particle_emitter.delay_ms -= dt;
@@ -53,4 +85,4 @@ void ParticleSystem::step(float dt) {
     }
 }
 
-ParticleSystem::ParticleSystem(): generator(rd()), float_distribution(0, 1.0f) {}
+ParticleSystem::ParticleSystem() : random_stream(RngService::getInstance().stream(RNG_STREAM::PARTICLES)) {}
@@ -0,0 +1,246 @@
+#include "perf_hud.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "common.hpp"
+#include "frame_stats.hpp"
+#include "tinyECS/registry.hpp"
+
+namespace {
+
+// top-left corner of the panel and its layout, in window pixels with y down
+const vec2 panel_origin = {8.f, 8.f};
+const float panel_width = 340.f;
+const float panel_padding = 6.f;
+const float line_height = 13.f;
+const float text_scale = 0.7f;
+
+const float graph_top = 34.f;
+const float graph_height = 48.f;
+const float graph_full_scale_ms = 2.f * 1000.f / 60.f;  // the 60 FPS budget sits halfway up
+
+const float systems_top = graph_top + graph_height + 18.f;
+const float system_name_width = 120.f;
+const float system_value_x = 76.f;  // the font is proportional, so names and values get their own columns
+const float system_bar_full_scale_ms = 1000.f / 60.f;
+const float counters_top = systems_top + sim_system_count * line_height + 6.f;
+const int gpu_lines = 2;
+const int entity_lines = 4;
+const size_t line_chars = 48;
+const float panel_height = counters_top + (gpu_lines + 2 + entity_lines) * line_height;
+
+const vec3 panel_color = {0.08f, 0.08f, 0.1f};
+const vec3 text_color = {0.95f, 0.95f, 0.95f};
+const vec3 system_bar_color = {0.35f, 0.6f, 0.95f};
+const vec3 budget_line_color = {0.6f, 0.6f, 0.6f};
+
+std::shared_ptr<bnuui::SimpleBox> makeBox(vec2 top_left, vec2 size, vec3 color) {
+    auto box = std::make_shared<bnuui::SimpleBox>(top_left + size / 2.f, size, 0.f);
+    box->color = color;
+    return box;
+}
+
+// green within the 60 FPS budget, yellow within 30 FPS, red beyond
+vec3 frameColor(float frame_ms) {
+    if (frame_ms <= 1000.f / 60.f + 0.5f) return {0.3f, 0.85f, 0.3f};
+    if (frame_ms <= 1000.f / 30.f + 0.5f) return {0.95f, 0.8f, 0.2f};
+    return {0.95f, 0.25f, 0.2f};
+}
+
+// a bar whose left edge stays put while its width changes
+void setBarWidth(bnuui::Element& bar, float left, float width) {
+    bar.scale.x = width;
+    bar.position.x = left + width / 2.f;
+}
+
+}  // namespace
+
+PerfHud& PerfHud::getInstance() {
+    static PerfHud instance;
+    return instance;
+}
+
+PerfHud::PerfHud() {
+    elems.push_back(makeBox(panel_origin, {panel_width, panel_height}, panel_color));
+
+    float graph_bar_width = (panel_width - 2.f * panel_padding) / PERF_HUD_GRAPH_FRAMES;
+    for (size_t i = 0; i < PERF_HUD_GRAPH_FRAMES; i++) {
+        vec2 top_left = panel_origin + vec2(panel_padding + i * graph_bar_width, graph_top + graph_height);
+        graph_bars.push_back(makeBox(top_left, {graph_bar_width, 0.f}, frameColor(0.f)));
+        elems.push_back(graph_bars.back());
+    }
+    float budget_y = graph_top + graph_height * (1.f - (1000.f / 60.f) / graph_full_scale_ms);
+    elems.push_back(makeBox(panel_origin + vec2(panel_padding, budget_y),
+                            {panel_width - 2.f * panel_padding, 1.f},
+                            budget_line_color));
+
+    for (int i = 0; i < sim_system_count; i++) {
+        vec2 top_left = panel_origin + vec2(system_name_width, systems_top + (i - 1) * line_height + 3.f);
+        system_bars[i] = makeBox(top_left, {0.f, line_height - 4.f}, system_bar_color);
+        elems.push_back(system_bars[i]);
+    }
+
+    frame_label = addLabel({panel_padding, line_height});
+    // just above the graph
+    percentile_label = addLabel({panel_padding, 2.f * line_height});
+    for (int i = 0; i < sim_system_count; i++) {
+        addLabel({panel_padding, systems_top + i * line_height})->setText(sim_system_names[i]);
+        system_labels[i] = addLabel({system_value_x, systems_top + i * line_height});
+    }
+    for (int i = 0; i < gpu_lines; i++) {
+        gpu_labels.push_back(addLabel({panel_padding, counters_top + i * line_height}));
+    }
+    draw_label = addLabel({panel_padding, counters_top + gpu_lines * line_height});
+    totals_label = addLabel({panel_padding, counters_top + (gpu_lines + 1) * line_height});
+    for (int i = 0; i < entity_lines; i++) {
+        entity_labels.push_back(addLabel({panel_padding, counters_top + (gpu_lines + 2 + i) * line_height}));
+    }
+}
+
+std::shared_ptr<bnuui::TextLabel> PerfHud::addLabel(vec2 position) {
+    auto label = std::make_shared<bnuui::TextLabel>(panel_origin + position, text_scale, " ", true);
+    label->color = text_color;
+    elems.push_back(label);
+    return label;
+}
+
+void PerfHud::update(float elapsed_ms) {
+    if (!visible) return;
+    updateGraph();
+
+    // numbers that change every frame are unreadable, the text only follows a few times a second
+    text_timer_ms -= elapsed_ms;
+    if (text_timer_ms > 0.f) return;
+    text_timer_ms = PERF_HUD_TEXT_REFRESH_MS;
+    updateText();
+}
+
+void PerfHud::updateGraph() {
+    const FrameStats& frame_stats = FrameStats::getInstance();
+    float graph_bottom = panel_origin.y + graph_top + graph_height;
+    for (size_t i = 0; i < graph_bars.size(); i++) {
+        // newest frame on the right
+        size_t age = graph_bars.size() - 1 - i;
+        float frame_ms = age < frame_stats.size() ? frame_stats.frame(age).frame_ms : 0.f;
+        float height = std::min(frame_ms / graph_full_scale_ms, 1.f) * graph_height;
+        bnuui::SimpleBox& bar = *graph_bars[i];
+        bar.scale.y = height;
+        bar.position.y = graph_bottom - height / 2.f;
+        bar.color = frameColor(frame_ms);
+    }
+
+    // bars show the average over the graph's frames
+    size_t frames = std::min(frame_stats.size(), PERF_HUD_GRAPH_FRAMES);
+    float bar_left = panel_origin.x + system_name_width;
+    float bar_max_width = panel_width - system_name_width - panel_padding;
+    for (int i = 0; i < sim_system_count; i++) {
+        float total_ms = 0.f;
+        for (size_t age = 0; age < frames; age++) total_ms += frame_stats.frame(age).system_ms[i];
+        float average_ms = frames > 0 ? total_ms / frames : 0.f;
+        setBarWidth(*system_bars[i], bar_left, std::min(average_ms / system_bar_full_scale_ms, 1.f) * bar_max_width);
+    }
+}
+
+void PerfHud::updateText() {
+    const FrameStats& frame_stats = FrameStats::getInstance();
+    if (frame_stats.size() == 0) return;
+    const FrameSample& latest = frame_stats.frame(0);
+    char line[128];
+
+    FrameTimeSummary summary = frame_stats.summarize(&FrameSample::frame_ms);
+    snprintf(line,
+             sizeof(line),
+             "frame %.2f ms  update %.2f  render %.2f",
+             latest.frame_ms,
+             latest.update_ms,
+             latest.render_ms);
+    frame_label->setText(line);
+    snprintf(line,
+             sizeof(line),
+             "p50 %.1f  p95 %.1f  p99 %.1f  max %.1f",
+             summary.p50,
+             summary.p95,
+             summary.p99,
+             summary.max);
+    percentile_label->setText(line);
+
+    size_t frames = std::min(frame_stats.size(), PERF_HUD_GRAPH_FRAMES);
+    for (int i = 0; i < sim_system_count; i++) {
+        float total_ms = 0.f;
+        for (size_t age = 0; age < frames; age++) total_ms += frame_stats.frame(age).system_ms[i];
+        snprintf(line, sizeof(line), "%.2f", total_ms / frames);
+        system_labels[i]->setText(line);
+    }
+
+    updateGpuText(latest);
+
+    snprintf(line,
+             sizeof(line),
+             "draws %d  sprites %d  gl %d (+%d elided)",
+             latest.draw_calls,
+             latest.sprites,
+             latest.gl_calls_issued,
+             latest.gl_calls_elided);
+    draw_label->setText(line);
+
+    size_t particles = 0;
+    for (const ParticleEmitter& emitter : registry.particleEmitters.components) particles += emitter.particles.count;
+    snprintf(line,
+             sizeof(line),
+             "particles %zu  projectiles %zu  allocs %u",
+             particles,
+             registry.playerProjectiles.size() + registry.enemyProjectiles.size(),
+             latest.allocations);
+    totals_label->setText(line);
+
+    // the non-empty containers, as many as fit
+    std::vector<std::string> entries;
+    for (size_t i = 0; i < registry.container_count(); i++) {
+        size_t size = registry.container_size(i);
+        if (size > 0) entries.push_back(std::string(registry.container_name(i)) + " " + std::to_string(size));
+    }
+    wrapText(entries, entity_labels);
+}
+
+void PerfHud::updateGpuText(const FrameSample& latest) {
+    if (latest.gpu_ms <= 0.f) {
+        wrapText({"gpu timing unavailable"}, gpu_labels);
+        return;
+    }
+    char entry[32];
+    std::vector<std::string> entries;
+    snprintf(entry, sizeof(entry), "gpu %.2f ms", latest.gpu_ms);
+    entries.push_back(entry);
+    // heaviest passes first, the cheap ones fall off the end when the lines are full
+    std::array<int, gpu_pass_count> passes;
+    for (int i = 0; i < gpu_pass_count; i++) passes[i] = i;
+    std::sort(passes.begin(), passes.end(), [&](int a, int b) {
+        return latest.gpu_pass_ms[a] > latest.gpu_pass_ms[b];
+    });
+    for (int pass : passes) {
+        snprintf(entry, sizeof(entry), "%s %.2f", gpu_pass_names[pass], latest.gpu_pass_ms[pass]);
+        entries.push_back(entry);
+    }
+    wrapText(entries, gpu_labels);
+}
+
+void PerfHud::wrapText(const std::vector<std::string>& entries,
+                       const std::vector<std::shared_ptr<bnuui::TextLabel>>& labels) {
+    std::string text;
+    size_t line = 0;
+    for (const std::string& entry : entries) {
+        if (!text.empty() && text.size() + entry.size() > line_chars) {
+            labels[line++]->setText(text);
+            text.clear();
+            if (line == labels.size()) return;
+        }
+        text += entry + "  ";
+    }
+    for (; line < labels.size(); line++) {
+        labels[line]->setText(text.empty() ? " " : text);
+        text.clear();
+    }
+}
@@ -1,16 +1,32 @@
 // internal
 #include "physics_system.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "camera_system.hpp"
+#include "contact_cache.hpp"
+#include "frame_arena.hpp"
+#include "narrowphase.hpp"
+#include "profiler.hpp"
+#include "worker_pool.hpp"
 #include "tinyECS/registry.hpp"
 #include "world_init.hpp"
 #include "../ext/earcut/earcut.hpp"
 
+namespace {
+// shared by every level's PhysicsSystem, the calling thread also works so leave one core for it
+WorkerPool& physicsWorkers() {
+    static WorkerPool pool(std::min(std::max(std::thread::hardware_concurrency(), 1u) - 1, PHYSICS_MAX_WORKER_THREADS));
+    return pool;
+}
+}  // namespace
+
 using Coord = double;
 using N = uint32_t;
 using Point = std::array<Coord, 2>;
+// the float copies of polygons the SAT tests work on, they only live for one test
+using FramePolygon = FrameVector<vec2>;
 
 // #include "camera_system.hpp"
 
@@ -39,8 +55,12 @@ bool lineLine(int x1, int y1, int x2, int y2, int x3, int y3, int x4, int y4) {
     return false;
 }
 
+// The polygon tests take any container of tson::Vector2i, islands keep std::vector and the
+// per-test copies are FrameVectors or fixed arrays
+
 // POLYGON/LINE
-bool polyLine(std::vector<tson::Vector2i> vertices, int x1, int y1, int x2, int y2) {
+template <typename Polygon>
+bool polyLine(const Polygon& vertices, int x1, int y1, int x2, int y2) {
     // go through each of the vertices, plus the next
     // vertex in the list
     int next = 0;
@@ -73,7 +93,8 @@ bool polyLine(std::vector<tson::Vector2i> vertices, int x1, int y1, int x2, int
 // POLYGON/POINT
 // used only to check if the second polygon is
 // INSIDE the first
-bool polyPoint(std::vector<tson::Vector2i> vertices, float px, float py) {
+template <typename Polygon>
+bool polyPoint(const Polygon& vertices, float px, float py) {
     bool collision = false;
 
     // go through each of the vertices, plus the next
@@ -102,7 +123,8 @@ bool polyPoint(std::vector<tson::Vector2i> vertices, float px, float py) {
 
 // POLYGON/POLYGON: all of this along with helpers from
 // (https://www.jeffreythompson.org/collision-detection/poly-poly.php)
-bool polyPoly(std::vector<tson::Vector2i> p1, std::vector<tson::Vector2i> p2) {
+template <typename PolygonA, typename PolygonB>
+bool polyPoly(const PolygonA& p1, const PolygonB& p2) {
     // go through each of the vertices, plus the next
     // vertex in the list
     int next = 0;
@@ -126,7 +148,8 @@ bool polyPoly(std::vector<tson::Vector2i> p1, std::vector<tson::Vector2i> p2) {
     return false;
 }
 
-bool polyPolyInside(std::vector<tson::Vector2i> p1, std::vector<tson::Vector2i> p2) { // only true if one polygon is completely in the other
+template <typename PolygonA, typename PolygonB>
+bool polyPolyInside(const PolygonA& p1, const PolygonB& p2) { // only true if one polygon is completely in the other
     // go through each of the vertices, plus the next
     // vertex in the list
     // check if the 1st polygon is INSIDE the second
@@ -140,7 +163,7 @@ bool polyPolyInside(std::vector<tson::Vector2i> p1, std::vector<tson::Vector2i>
 }
 
 // Collision using "axis-aligned" rectangular bounding boxes
-bool polyAABB(const std::vector<vec2> p1, const std::vector<vec2> p2) {
+bool polyAABB(const FramePolygon& p1, const FramePolygon& p2) {
     // get bounding box of p1
     float minX1 = p1[0].x, maxX1 = p1[0].x;
     float minY1 = p1[0].y, maxY1 = p1[0].y;
@@ -165,25 +188,7 @@ bool polyAABB(const std::vector<vec2> p1, const std::vector<vec2> p2) {
     return (maxX1 >= minX2 && minX1 <= maxX2) && (maxY1 >= minY2 && minY1 <= maxY2);
 }
 
-bool collidesAABBMot(const Motion& motion1, const Motion& motion2) {
-    vec2 half_size1 = get_bounding_box(motion1) / 2.f;
-    vec2 half_size2 = get_bounding_box(motion2) / 2.f;
-
-    vec2 pos1 = motion1.position;
-    vec2 pos2 = motion2.position - CameraSystem::GetInstance()->position;
-
-    if (pos1.x + half_size1.x < pos2.x - half_size2.x || pos2.x + half_size2.x < pos1.x - half_size1.x) {
-        return false;
-    }
-
-    if (pos1.y + half_size1.y < pos2.y - half_size2.y || pos2.y + half_size2.y < pos1.y - half_size1.y) {
-        return false;
-    }
-
-    return true;
-}
-
-void projectPolygon(const std::vector<vec2>& poly, vec2 axis, float& min, float& max) {
+void projectPolygon(const FramePolygon& poly, vec2 axis, float& min, float& max) {
     min = max = dot(poly[0], axis);
     for (size_t i = 1; i < poly.size(); i++) {
         float proj = dot(poly[i], axis);
@@ -192,7 +197,7 @@ void projectPolygon(const std::vector<vec2>& poly, vec2 axis, float& min, float&
     }
 }
 
-bool collidesSAT(const std::vector<vec2>& p1, const std::vector<vec2>& p2, vec2& axis, float& overlap) {
+bool collidesSAT(const FramePolygon& p1, const FramePolygon& p2, vec2& axis, float& overlap) {
     float minOverlap = std::numeric_limits<float>::max();
     vec2 smallestAxis = {0, 0};
 
@@ -205,10 +210,10 @@ bool collidesSAT(const std::vector<vec2>& p1, const std::vector<vec2>& p2, vec2&
 
     vec2 displacement = centroid2 - centroid1;
 
-    for (const auto& poly : {p1, p2}) {
-        for (size_t i = 0; i < poly.size(); i++) {
-            size_t next = (i + 1) % poly.size();
-            vec2 edge = poly[next] - poly[i];
+    for (const FramePolygon* poly : {&p1, &p2}) {
+        for (size_t i = 0; i < poly->size(); i++) {
+            size_t next = (i + 1) % poly->size();
+            vec2 edge = (*poly)[next] - (*poly)[i];
             vec2 normal = {-edge.y, edge.x};
 
             normal = normalize(normal);
@@ -244,9 +249,14 @@ bool collidesSAT(const std::vector<vec2>& p1, const std::vector<vec2>& p2, vec2&
 }
 
 
-bool polyPolyMTV(const std::vector<tson::Vector2i>& poly1, const std::vector<tson::Vector2i>& poly2, vec2& mtv) {
+// warm_axis is the MTV of this pair from the previous step (zero if there was no contact), any triangle
+// it separates cannot overlap and skips the full SAT test
+template <typename PolygonA, typename PolygonB>
+bool polyPolyMTV(const PolygonA& poly1, const PolygonB& poly2, vec2& mtv, vec2 warm_axis = {0, 0}) {
     // convert polygons to use vec2 for easier math
-    std::vector<vec2> p1, p2;
+    FramePolygon p1, p2;
+    p1.reserve(poly1.size());
+    p2.reserve(poly2.size());
     for (const auto& v : poly1) {
         p1.push_back(vec2(static_cast<float>(v.x), static_cast<float>(v.y)));
     }
@@ -255,12 +265,12 @@ bool polyPolyMTV(const std::vector<tson::Vector2i>& poly1, const std::vector<tso
     }
 
     // earclip island polygon into convex triangles
-    std::vector<Point> p2Points;
+    FrameVector<FrameVector<Point>> p2Vec(1);  // vec2 doesn't work with earcut library, so converting to array
+    FrameVector<Point>& p2Points = p2Vec[0];
+    p2Points.reserve(p2.size());
     for (const auto& v : p2) {
         p2Points.push_back(Point{(float) v.x, (float) v.y});
     }
-    std::vector<std::vector<Point>> p2Vec;  // vec2 doesn't work with earcut library, so converting to array
-    p2Vec.push_back(p2Points);
 
     // an ordered list of indices of Points for the ear-clipped triangles (so every 3 indices is one triangle)
     std::vector<unsigned int> indices = mapbox::earcut<unsigned int>(p2Vec);
@@ -268,12 +278,24 @@ bool polyPolyMTV(const std::vector<tson::Vector2i>& poly1, const std::vector<tso
     float minOverlap = std::numeric_limits<float>::max();
     vec2 smallestAxis = {0, 0};
 
+    bool warm_started = warm_axis != vec2(0, 0);
+    float warmMinA, warmMaxA;
+    if (warm_started) {
+        warm_axis = normalize(warm_axis);
+        projectPolygon(p1, warm_axis, warmMinA, warmMaxA);
+    }
+
+    FramePolygon triangle(3);
     for (size_t i = 0; i < indices.size(); i += 3) {
-        std::vector<vec2> triangle;
         for (size_t j = 0; j < 3; ++j) {
             unsigned int index = indices[i + j];
-            vec2 triangleVertex = vec2(p2Points[index][0], p2Points[index][1]);
-            triangle.push_back(triangleVertex);
+            triangle[j] = vec2(p2Points[index][0], p2Points[index][1]);
+        }
+
+        if (warm_started) {
+            float minB, maxB;
+            projectPolygon(triangle, warm_axis, minB, maxB);
+            if (std::min(warmMaxA, maxB) - std::max(warmMinA, minB) <= 0) continue;
         }
 
         // do SAT and update axis/overlap for MTV calculation
@@ -298,103 +320,50 @@ bool polyPolyMTV(const std::vector<tson::Vector2i>& poly1, const std::vector<tso
 }
 
 
-// This is a SUPER APPROXIMATE check that puts a circle around the bounding
-// boxes and sees if the center point of either object is inside the other's
-// bounding-box-circle. You can surely implement a more accurate detection
-// Clare's note: add camera offset in calculation
-// Dayshaun's note: removed camera offset because made projectiles background offset
-bool collidesSpherical(const Motion& motion1, const Motion& motion2) {
-    vec2 dp = motion1.position - motion2.position;
-    float dist_squared = dot(dp, dp);
-    const vec2 other_bonding_box = get_bounding_box(motion1) / 2.f;
-    const float other_r_squared = dot(other_bonding_box, other_bonding_box);
-    const vec2 my_bonding_box = get_bounding_box(motion2) / 2.f;
-    const float my_r_squared = dot(my_bonding_box, my_bonding_box);
-    const float r_squared = max(other_r_squared, my_r_squared);
-    if (dist_squared < r_squared) return true;
-    return false;
-}
-
-bool collidesSphericalShip(const Entity e1, const Entity e2) {
-    Motion shipMotion;
-    Motion otherMotion;
-    if (registry.ships.has(e1)) {
-        otherMotion = registry.motions.get(e2);
-        shipMotion = registry.motions.get(e1);
-    } else {
-        otherMotion= registry.motions.get(e1);
-        shipMotion= registry.motions.get(e2);
-    }
-
-    otherMotion.position += CameraSystem::GetInstance()->position;
-
-
-    vec2 dp = otherMotion.position - shipMotion.position;
-    float dist_squared = dot(dp, dp);
-    const vec2 other_bonding_box = get_bounding_box(otherMotion) / 2.f;
-    const float other_r_squared = dot(other_bonding_box, other_bonding_box);
-    const vec2 my_bonding_box = get_bounding_box(shipMotion) / 2.f;
-    const float my_r_squared = dot(my_bonding_box, my_bonding_box);
-    const float r_squared = max(other_r_squared, my_r_squared);
-    if (dist_squared < r_squared) return true;
-    return false;
-}
-
 // Brian's Additional Feedback: I added the Camera Offset, but it might not be the EXACT outputs.
-bool shipCollides(const std::vector<tson::Vector2i>& entityPolygon, Entity entity, Entity ship, bool checkInside, vec2& mtv) {
-    Motion& entityMot = registry.motions.get(entity);
-    Motion& shipMot = registry.motions.get(ship);
-
-    std::vector<tson::Vector2i> adjustedPolygon = entityPolygon;
-    vec2 cameraPos = CameraSystem::GetInstance()->position;
+// Only reads its arguments so it can run on the narrowphase workers.
+bool shipCollides(const std::vector<tson::Vector2i>& entityPolygon,
+                  const Motion& entityMot,
+                  const Motion& shipMot,
+                  vec2 cameraPos,
+                  bool checkInside,
+                  vec2 warm_axis,
+                  vec2& mtv) {
+    FrameVector<tson::Vector2i> adjustedPolygon(entityPolygon.begin(), entityPolygon.end());
     for (auto& p : adjustedPolygon) {
         p.x += entityMot.position.x + cameraPos.x;
         p.y += entityMot.position.y + cameraPos.y;
     }
 
-    if (!collidesAABBMot(entityMot, shipMot)) return false;
-    return checkInside ? polyPolyInside(get_poly_from_motion(shipMot), adjustedPolygon)
-                       : polyPolyMTV(get_poly_from_motion(shipMot), adjustedPolygon, mtv);
+    // the bounding boxes were already tested by narrowphaseBoxes
+    if (checkInside) return polyPolyInside(get_corners_from_motion(shipMot), adjustedPolygon);
+    return polyPolyMTV(get_corners_from_motion(shipMot), adjustedPolygon, mtv, warm_axis);
 }
 
-// Polygon - Polygon collision
-bool collidesPoly(const Entity e1, const Entity e2, vec2& mtv) {
-    if (registry.islands.has(e1)) return shipCollides(registry.islands.get(e1).polygon, e1, e2, false, mtv);
-    if (registry.islands.has(e2)) return shipCollides(registry.islands.get(e2).polygon, e2, e1, false, mtv);
-    if (registry.base.has(e1)) return shipCollides(registry.base.get(e1).polygon, e1, e2, true, mtv);
-    if (registry.base.has(e2)) return shipCollides(registry.base.get(e2).polygon, e2, e1, true, mtv);
-
-    return false;  // should never reach
-}
-
-std::vector<tson::Vector2i> get_poly_from_node_pos(ivec2 node_pos) {
-    std::vector<tson::Vector2i> polygon;
+std::array<tson::Vector2i, 4> get_poly_from_node_pos(ivec2 node_pos) {
     int posX = node_pos.x * GRID_CELL_WIDTH_PX + GRID_CELL_WIDTH_PX / 2;
     int posY = node_pos.y * GRID_CELL_HEIGHT_PX + GRID_CELL_HEIGHT_PX / 2;
     int halfWidth = GRID_CELL_WIDTH_PX / 2;
     int halfHeight = GRID_CELL_HEIGHT_PX / 2;
 
-    // top left
-    polygon.push_back(tson::Vector2i(posX - halfWidth, posY - halfHeight));
-    // top right
-    polygon.push_back(tson::Vector2i(posX + halfWidth, posY - halfHeight));
-    // bottom right
-    polygon.push_back(tson::Vector2i(posX + halfWidth, posY + halfHeight));
-    // bottom left
-    polygon.push_back(tson::Vector2i(posX - halfWidth, posY + halfHeight));
-
-    return polygon;
+    return {
+        tson::Vector2i(posX - halfWidth, posY - halfHeight),  // top left
+        tson::Vector2i(posX + halfWidth, posY - halfHeight),  // top right
+        tson::Vector2i(posX + halfWidth, posY + halfHeight),  // bottom right
+        tson::Vector2i(posX - halfWidth, posY + halfHeight)   // bottom left
+    };
 }
 
 bool PhysicsSystem::collidesPolyVec(Entity island_entity, ivec2 node_pos) {
     Motion& island_motion = registry.motions.get(island_entity);
-    std::vector<tson::Vector2i> islandPolygon;
-    std::vector<tson::Vector2i> nodePolygon;
-    islandPolygon = registry.islands.get(island_entity).polygon;
-    nodePolygon = get_poly_from_node_pos(node_pos);
-    for (auto& p : islandPolygon) {
-        p.x += island_motion.position.x;
-        p.y += island_motion.position.y;
+    const std::vector<tson::Vector2i>& islandPolygon = registry.islands.get(island_entity).polygon;
+    // move the node into island space instead of the whole island into world space
+    int offsetX = (int) floor(island_motion.position.x);
+    int offsetY = (int) floor(island_motion.position.y);
+    std::array<tson::Vector2i, 4> nodePolygon = get_poly_from_node_pos(node_pos);
+    for (auto& p : nodePolygon) {
+        p.x -= offsetX;
+        p.y -= offsetY;
     }
 
     return polyPoly(islandPolygon, nodePolygon);
@@ -405,11 +374,16 @@ void PhysicsSystem::step(float elapsed_ms) {
 
     // Move each entity that has motion.
     auto& motion_registry = registry.motions;
+    PROFILE_ZONE_NAMED(integrate_zone, "physics.integrate");
+    integrateMotions(motion_registry, elapsed_ms / 1000.f);
+
+    PROFILE_ZONE_END(integrate_zone);
+
+    // Gameplay movement rules, applied on top of the integrated positions
+    PROFILE_ZONE_NAMED(rules_zone, "physics.rules");
     for (uint i = 0; i < motion_registry.size(); i++) {
         Motion& motion = motion_registry.components[i];
         Entity entity = motion_registry.entities[i];
-        float step_seconds = elapsed_ms / 1000.f;
-        motion.position += motion.velocity * step_seconds;
 
         // Player - Ship collision: Don't allow Player to walk outside of the ship boundaries
         if (registry.ships.components.size() > 0 && registry.players.has(entity)) {
@@ -512,47 +486,166 @@ void PhysicsSystem::step(float elapsed_ms) {
         }
     }
 
+    PROFILE_ZONE_END(rules_zone);
+
     // check for collisions between all moving entities
+    PROFILE_ZONE_NAMED(broadphase_zone, "physics.broadphase");
     ComponentContainer<Motion>& motion_container = registry.motions;
-    Base& base = registry.base.components[0];
-    for (uint i = 0; i < motion_container.components.size(); i++) {
-        Motion& motion_i = motion_container.components[i];
-        Entity entity_i = motion_container.entities[i];
-
-        // note starting j at i+1 to compare all (i,j) pairs only once (and to not
-        // compare with itself)
-        for (uint j = i + 1; j < motion_container.components.size(); j++) {
-            Entity entity_j = motion_container.entities[j];
-            Motion& motion_j = motion_container.components[j];
-            vec2 mtv = {0.0, 0.0};
-            if (registry.islands.has(entity_i) || registry.islands.has(entity_j)) {
-                // Poly collision only for islands.
-                if ((registry.ships.has(entity_i) || registry.ships.has(entity_j))
-                        && collidesPoly(entity_i, entity_j, mtv)) {
-                    assert(mtv != vec2(0, 0));
-                    registry.collisions.emplace_with_duplicates(entity_i, entity_j, mtv);
-                }
-            } else if ((registry.base.has(entity_i) || registry.base.has(entity_j)) &&
-                       (registry.ships.has(entity_i) || registry.ships.has(entity_j))) {
-                // Poly collision for base
-                if (collidesPoly(entity_i, entity_j, mtv)) {
-                    registry.collisions.emplace_with_duplicates(entity_i, entity_j, mtv);
-                    if (!base.ship_in_base) base.ship_in_base = true;
-                    else base.drop_off_timer += elapsed_ms;
-                } else {
-                    if (base.ship_in_base) {
-                        base.ship_in_base = false;
-                        base.drop_off_timer = 0;
-                    }        
+    vec2 camera_pos = CameraSystem::GetInstance()->position;
+    size_t body_count = motion_container.components.size();
+
+    // per body data, looked up once instead of once per pair
+    body_flags.resize(body_count);
+    body_half_extents.resize(body_count);
+    body_r_squared.resize(body_count);
+    for (uint i = 0; i < body_count; i++) {
+        Entity entity = motion_container.entities[i];
+        body_flags[i] = (registry.islands.has(entity) ? BODY_ISLAND : 0) | (registry.base.has(entity) ? BODY_BASE : 0) |
+                        (registry.ships.has(entity) ? BODY_SHIP : 0);
+        body_half_extents[i] = get_bounding_box(motion_container.components[i]) / 2.f;
+        body_r_squared[i] = dot(body_half_extents[i], body_half_extents[i]);
+    }
+
+    // circle lanes are tested a block at a time as they fill, so the pair lists stay small
+    // however many bodies there are
+    circle_hits.clear();
+    circle_pairs.clear();
+    auto flush_circle_pairs = [&]() {
+        narrowphase_hits.clear();
+        narrowphaseCircles(circle_pairs, 0, circle_pairs.size(), narrowphase_hits);
+        for (uint32_t k : narrowphase_hits) {
+            circle_hits.push_back({circle_pairs.first[k], circle_pairs.second[k], {0.0, 0.0}});
+        }
+        circle_pairs.clear();
+    };
+
+    // note starting j at i+1 to compare all (i,j) pairs only once (and to not
+    // compare with itself)
+    box_pairs.clear();
+    for (uint i = 0; i < body_count; i++) {
+        const vec2& pos_i = motion_container.components[i].position;
+        for (uint j = i + 1; j < body_count; j++) {
+            const vec2& pos_j = motion_container.components[j].position;
+            uint8_t flags = body_flags[i] | body_flags[j];
+            bool has_ship = flags & BODY_SHIP;
+
+            if (flags & (BODY_ISLAND | BODY_BASE)) {
+                // Poly collision only between the ship and islands / base, boxes first.
+                // The island / base is in world space, the ship in screen space.
+                if (!has_ship) {
+                    if (flags & BODY_ISLAND) continue;
+                    // anything else over the base only gets the circle test
+                    circle_pairs.push(i, j, pos_i, body_r_squared[i], pos_j, body_r_squared[j]);
+                    continue;
                 }
-            } else if (registry.ships.has(entity_i) || registry.ships.has(entity_j)){
-                // Handle SHIP collision.
-                if (collidesSphericalShip(entity_i, entity_j))
-                    registry.collisions.emplace_with_duplicates(entity_i, entity_j); 
-            } else if (collidesSpherical(motion_i, motion_j)) {
+                uint ship = (body_flags[i] & BODY_SHIP) ? i : j;
+                uint other = ship == i ? j : i;
+                box_pairs.push(i,
+                               j,
+                               motion_container.components[other].position,
+                               body_half_extents[other],
+                               motion_container.components[ship].position - camera_pos,
+                               body_half_extents[ship]);
+            } else if (has_ship) {
+                // Handle SHIP collision: everything but the ship moves with the camera
+                uint ship = (body_flags[i] & BODY_SHIP) ? i : j;
+                uint other = ship == i ? j : i;
+                circle_pairs.push(i,
+                                  j,
+                                  motion_container.components[ship].position,
+                                  body_r_squared[ship],
+                                  motion_container.components[other].position + camera_pos,
+                                  body_r_squared[other]);
+            } else {
                 // Every other collision.
-                registry.collisions.emplace_with_duplicates(entity_i, entity_j);
+                circle_pairs.push(i, j, pos_i, body_r_squared[i], pos_j, body_r_squared[j]);
             }
+            if (circle_pairs.size() >= NARROWPHASE_CIRCLE_BLOCK) flush_circle_pairs();
         }
     }
+    flush_circle_pairs();
+
+    PROFILE_ZONE_END(broadphase_zone);
+
+    PROFILE_ZONE_NAMED(narrowphase_zone, "physics.narrowphase");
+    // boxes are cheap, run them here and look up everything the polygon tests need, the
+    // registry is not safe to read from the workers
+    narrowphase_hits.clear();
+    narrowphaseBoxes(box_pairs, 0, box_pairs.size(), narrowphase_hits);
+    poly_pairs.clear();
+    for (uint32_t k : narrowphase_hits) {
+        uint i = box_pairs.first[k];
+        uint j = box_pairs.second[k];
+        uint ship = (body_flags[i] & BODY_SHIP) ? i : j;
+        uint other = ship == i ? j : i;
+        Entity ship_entity = motion_container.entities[ship];
+        Entity other_entity = motion_container.entities[other];
+
+        PolyPair pair;
+        pair.first = i;
+        pair.second = j;
+        pair.entity_motion = &motion_container.components[other];
+        pair.ship_motion = &motion_container.components[ship];
+        pair.check_inside = !(body_flags[other] & BODY_ISLAND);
+        pair.polygon = pair.check_inside ? &registry.base.get(other_entity).polygon
+                                         : &registry.islands.get(other_entity).polygon;
+        const Contact* contact = ContactCache::getInstance().find(other_entity, ship_entity);
+        pair.warm_axis = contact ? contact->mtv : vec2(0, 0);
+        poly_pairs.push_back(pair);
+    }
+
+    // split the polygon tests into tasks, each with its own hit buffer
+    size_t poly_tasks = (poly_pairs.size() + NARROWPHASE_POLY_TASK_SIZE - 1) / NARROWPHASE_POLY_TASK_SIZE;
+    if (narrowphase_tasks.size() < poly_tasks) narrowphase_tasks.resize(poly_tasks);
+
+    physicsWorkers().run(poly_tasks, [&](size_t task) {
+        PROFILE_ZONE("physics.narrowphase.task");
+        NarrowphaseTask& out = narrowphase_tasks[task];
+        out.hits.clear();
+        size_t begin = task * NARROWPHASE_POLY_TASK_SIZE;
+        size_t end = std::min(begin + NARROWPHASE_POLY_TASK_SIZE, poly_pairs.size());
+        for (size_t k = begin; k < end; k++) {
+            const PolyPair& pair = poly_pairs[k];
+            vec2 mtv = {0.0, 0.0};
+            if (shipCollides(*pair.polygon,
+                             *pair.entity_motion,
+                             *pair.ship_motion,
+                             camera_pos,
+                             pair.check_inside,
+                             pair.warm_axis,
+                             mtv)) {
+                assert(mtv != vec2(0, 0) || pair.check_inside);
+                out.hits.push_back({pair.first, pair.second, mtv});
+            }
+        }
+    });
+    PROFILE_ZONE_END(narrowphase_zone);
+
+    // merge in entity pair order, so the collision list does not depend on how the work was split
+    PROFILE_ZONE_NAMED(merge_zone, "physics.merge");
+    merged_hits.clear();
+    auto merge = [&](const std::vector<NarrowphaseHit>& hits) {
+        for (const NarrowphaseHit& hit : hits) {
+            Entity entity_i = motion_container.entities[hit.first];
+            Entity entity_j = motion_container.entities[hit.second];
+            uint64_t key = ((uint64_t) (unsigned int) entity_i << 32) | (unsigned int) entity_j;
+            merged_hits.push_back({key, hit});
+        }
+    };
+    merge(circle_hits);
+    for (size_t task = 0; task < poly_tasks; task++) merge(narrowphase_tasks[task].hits);
+    std::sort(merged_hits.begin(), merged_hits.end(), [](const MergedHit& l, const MergedHit& r) {
+        return l.key < r.key;
+    });
+    for (const MergedHit& merged : merged_hits) {
+        Entity entity_i = motion_container.entities[merged.hit.first];
+        Entity entity_j = motion_container.entities[merged.hit.second];
+        registry.collisions.emplace_with_duplicates(entity_i, entity_j, merged.hit.mtv);
+    }
+
+    PROFILE_ZONE_END(merge_zone);
+
+    // remember which pairs touched so gameplay gets enter / stay / exit transitions
+    PROFILE_ZONE("physics.contacts");
+    ContactCache::getInstance().update(elapsed_ms);
 }
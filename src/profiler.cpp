@@ -0,0 +1,150 @@
+#include "profiler.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// 24 bytes each, 6 MB per thread that records a zone; later zones are dropped and counted
+const size_t events_per_thread = 1 << 18;
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+struct ThreadBuffer {
+    uint32_t thread_id = 0;
+    std::string thread_name;
+    // allocated by the first zone, so naming a thread that never records costs nothing
+    std::unique_ptr<ProfileEvent[]> events;
+    // only the owning thread writes, the count is published after the event so readers see whole events
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+};
+
+// buffers live until exit, so a thread that ends mid-capture still shows up in the trace
+std::mutex buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+thread_local ThreadBuffer* local_buffer = nullptr;
+uint64_t capture_start_ns = 0;
+
+ThreadBuffer& localBuffer() {
+    if (local_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        local_buffer = buffers.back().get();
+        local_buffer->thread_id = (uint32_t) buffers.size();
+    }
+    return *local_buffer;
+}
+
+void writeJSONString(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', file);
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+}  // namespace
+
+uint64_t Profiler::now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Profiler::start() {
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        for (auto& buffer : buffers) {
+            buffer->count.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+    capture_start_ns = now();
+    capturing.store(true, std::memory_order_release);
+}
+
+void Profiler::stop() {
+    capturing.store(false, std::memory_order_release);
+}
+
+void Profiler::nameThread(const char* name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffer.thread_name = name;
+}
+
+void Profiler::record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    if (!isCapturing()) return;
+    ThreadBuffer& buffer = localBuffer();
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= events_per_thread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!buffer.events) buffer.events = std::make_unique<ProfileEvent[]>(events_per_thread);
+    buffer.events[index] = {name, start_ns, end_ns};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) {
+    stop();
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "ERROR: Could not write trace " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    size_t event_count = 0;
+    size_t dropped = 0;
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (const auto& buffer : buffers) {
+        if (!buffer->thread_name.empty()) {
+            fprintf(file,
+                    "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",\n",
+                    buffer->thread_id);
+            writeJSONString(file, buffer->thread_name.c_str());
+            fprintf(file, "}}");
+            first = false;
+        }
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const ProfileEvent& event = buffer->events[i];
+            // zones opened before start() would have negative timestamps, clamp them to the capture
+            uint64_t start_ns = std::max(event.start_ns, capture_start_ns);
+            fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":", first ? "" : ",\n", buffer->thread_id);
+            writeJSONString(file, event.name);
+            fprintf(file,
+                    ",\"ts\":%.3f,\"dur\":%.3f}",
+                    (start_ns - capture_start_ns) / 1000.0,
+                    (event.end_ns - start_ns) / 1000.0);
+            first = false;
+        }
+        event_count += count;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = ferror(file) == 0;
+    fclose(file);
+
+    printf("Wrote %zu zones to %s", event_count, path.c_str());
+    if (dropped > 0) printf(" (%zu dropped, the per-thread buffers were full)", dropped);
+    printf("\n");
+    return ok;
+}
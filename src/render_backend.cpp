@@ -0,0 +1,464 @@
+#include "render_backend.hpp"
+
+// stlib
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+bool parseRenderBackend(const std::string& name, RENDER_BACKEND& backend) {
+    if (name == "window") {
+        backend = RENDER_BACKEND::WINDOW;
+    } else if (name == "headless") {
+        backend = RENDER_BACKEND::HEADLESS;
+    } else if (name == "null") {
+        backend = RENDER_BACKEND::NULL_GL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ========= HEADLESS (EGL) =========
+
+#ifdef HAVE_EGL
+namespace {
+EGLDisplay egl_display = EGL_NO_DISPLAY;
+EGLContext egl_context = EGL_NO_CONTEXT;
+EGLSurface egl_surface = EGL_NO_SURFACE;
+
+EGLDisplay openEGLDisplay() {
+    // surfaceless needs no GPU or display server, fall back to whatever the default display is
+    auto get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+        EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) return display;
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) return display;
+    return EGL_NO_DISPLAY;
+}
+}  // namespace
+
+bool createHeadlessContext() {
+    egl_display = openEGLDisplay();
+    if (egl_display == EGL_NO_DISPLAY) {
+        std::cerr << "ERROR: Failed to open an EGL display" << std::endl;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "ERROR: EGL has no desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    const EGLint config_attributes[] = {EGL_SURFACE_TYPE,
+                                        EGL_PBUFFER_BIT,
+                                        EGL_RENDERABLE_TYPE,
+                                        EGL_OPENGL_BIT,
+                                        EGL_RED_SIZE,
+                                        8,
+                                        EGL_GREEN_SIZE,
+                                        8,
+                                        EGL_BLUE_SIZE,
+                                        8,
+                                        EGL_ALPHA_SIZE,
+                                        8,
+                                        EGL_NONE};
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(egl_display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        std::cerr << "ERROR: No EGL config for an offscreen OpenGL context" << std::endl;
+        return false;
+    }
+
+    // same version and profile as the window in WorldSystem::create_window
+    const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                         3,
+                                         EGL_CONTEXT_MINOR_VERSION,
+                                         3,
+                                         EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                         EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                         EGL_NONE};
+    egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT) {
+        std::cerr << "ERROR: Failed to create an OpenGL 3.3 core context with EGL" << std::endl;
+        return false;
+    }
+
+    // the renderer only draws into framebuffer objects, a 1x1 pbuffer covers drivers without surfaceless
+    if (!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+        const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        egl_surface = eglCreatePbufferSurface(egl_display, config, pbuffer_attributes);
+        if (egl_surface == EGL_NO_SURFACE || !eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context)) {
+            std::cerr << "ERROR: Failed to make the EGL context current" << std::endl;
+            return false;
+        }
+    }
+
+    // gl3w resolves through libGL, whose dispatch also serves EGL contexts under libglvnd
+    if (gl3w_init() != 0) {
+        std::cerr << "ERROR: Failed to load OpenGL functions for the headless context" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void destroyHeadlessContext() {
+    if (egl_display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (egl_surface != EGL_NO_SURFACE) eglDestroySurface(egl_display, egl_surface);
+    if (egl_context != EGL_NO_CONTEXT) eglDestroyContext(egl_display, egl_context);
+    eglTerminate(egl_display);
+    egl_display = EGL_NO_DISPLAY;
+    egl_context = EGL_NO_CONTEXT;
+    egl_surface = EGL_NO_SURFACE;
+}
+#else
+bool createHeadlessContext() {
+    std::cerr << "ERROR: This build has no EGL, the headless backend is unavailable" << std::endl;
+    return false;
+}
+
+void destroyHeadlessContext() {}
+#endif
+
+// ========= NULL GL =========
+
+namespace {
+std::vector<const char*> null_gl_commands;
+GLuint null_gl_next_name = 1;
+std::vector<uint8_t> null_gl_mapped;
+
+void record(const char* name) {
+    null_gl_commands.push_back(name);
+}
+
+void generateNames(GLsizei n, GLuint* names) {
+    for (GLsizei i = 0; i < n; i++) names[i] = null_gl_next_name++;
+}
+
+void APIENTRY nullActiveTexture(GLenum) { record("glActiveTexture"); }
+void APIENTRY nullAttachShader(GLuint, GLuint) { record("glAttachShader"); }
+void APIENTRY nullBindBuffer(GLenum, GLuint) { record("glBindBuffer"); }
+void APIENTRY nullBindFramebuffer(GLenum, GLuint) { record("glBindFramebuffer"); }
+void APIENTRY nullBindRenderbuffer(GLenum, GLuint) { record("glBindRenderbuffer"); }
+void APIENTRY nullBindTexture(GLenum, GLuint) { record("glBindTexture"); }
+void APIENTRY nullBindVertexArray(GLuint) { record("glBindVertexArray"); }
+void APIENTRY nullBlendFunc(GLenum, GLenum) { record("glBlendFunc"); }
+void APIENTRY nullBufferData(GLenum, GLsizeiptr, const void*, GLenum) { record("glBufferData"); }
+void APIENTRY nullBufferSubData(GLenum, GLintptr, GLsizeiptr, const void*) { record("glBufferSubData"); }
+GLenum APIENTRY nullCheckFramebufferStatus(GLenum) {
+    record("glCheckFramebufferStatus");
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+void APIENTRY nullClear(GLbitfield) { record("glClear"); }
+void APIENTRY nullClearColor(GLfloat, GLfloat, GLfloat, GLfloat) { record("glClearColor"); }
+void APIENTRY nullClearDepth(GLdouble) { record("glClearDepth"); }
+void APIENTRY nullCompileShader(GLuint) { record("glCompileShader"); }
+GLuint APIENTRY nullCreateProgram() {
+    record("glCreateProgram");
+    return null_gl_next_name++;
+}
+GLuint APIENTRY nullCreateShader(GLenum) {
+    record("glCreateShader");
+    return null_gl_next_name++;
+}
+void APIENTRY nullDebugMessageCallback(GLDEBUGPROC, const void*) { record("glDebugMessageCallback"); }
+void APIENTRY nullDebugMessageControl(GLenum, GLenum, GLenum, GLsizei, const GLuint*, GLboolean) {
+    record("glDebugMessageControl");
+}
+void APIENTRY nullDeleteBuffers(GLsizei, const GLuint*) { record("glDeleteBuffers"); }
+void APIENTRY nullDeleteFramebuffers(GLsizei, const GLuint*) { record("glDeleteFramebuffers"); }
+void APIENTRY nullDeleteProgram(GLuint) { record("glDeleteProgram"); }
+void APIENTRY nullDeleteRenderbuffers(GLsizei, const GLuint*) { record("glDeleteRenderbuffers"); }
+void APIENTRY nullDeleteShader(GLuint) { record("glDeleteShader"); }
+void APIENTRY nullDeleteTextures(GLsizei, const GLuint*) { record("glDeleteTextures"); }
+void APIENTRY nullDeleteVertexArrays(GLsizei, const GLuint*) { record("glDeleteVertexArrays"); }
+void APIENTRY nullDepthRange(GLdouble, GLdouble) { record("glDepthRange"); }
+void APIENTRY nullDetachShader(GLuint, GLuint) { record("glDetachShader"); }
+void APIENTRY nullDisable(GLenum) { record("glDisable"); }
+void APIENTRY nullDrawArrays(GLenum, GLint, GLsizei) { record("glDrawArrays"); }
+void APIENTRY nullDrawElements(GLenum, GLsizei, GLenum, const void*) { record("glDrawElements"); }
+void APIENTRY nullDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) {
+    record("glDrawElementsInstanced");
+}
+void APIENTRY nullEnable(GLenum) { record("glEnable"); }
+void APIENTRY nullEnableVertexAttribArray(GLuint) { record("glEnableVertexAttribArray"); }
+void APIENTRY nullFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint) { record("glFramebufferRenderbuffer"); }
+void APIENTRY nullFramebufferTexture(GLenum, GLenum, GLuint, GLint) { record("glFramebufferTexture"); }
+void APIENTRY nullGenBuffers(GLsizei n, GLuint* names) {
+    record("glGenBuffers");
+    generateNames(n, names);
+}
+void APIENTRY nullGenFramebuffers(GLsizei n, GLuint* names) {
+    record("glGenFramebuffers");
+    generateNames(n, names);
+}
+void APIENTRY nullGenRenderbuffers(GLsizei n, GLuint* names) {
+    record("glGenRenderbuffers");
+    generateNames(n, names);
+}
+void APIENTRY nullGenTextures(GLsizei n, GLuint* names) {
+    record("glGenTextures");
+    generateNames(n, names);
+}
+void APIENTRY nullGenVertexArrays(GLsizei n, GLuint* names) {
+    record("glGenVertexArrays");
+    generateNames(n, names);
+}
+GLint APIENTRY nullGetAttribLocation(GLuint, const GLchar*) {
+    record("glGetAttribLocation");
+    return 0;
+}
+GLenum APIENTRY nullGetError() {
+    return GL_NO_ERROR;
+}
+void APIENTRY nullGetIntegerv(GLenum name, GLint* data) {
+    record("glGetIntegerv");
+    *data = name == GL_MAJOR_VERSION || name == GL_MINOR_VERSION ? 3 : 0;
+}
+// no timestamp counter, so the GPU pass timer turns itself off
+void APIENTRY nullGetQueryiv(GLenum, GLenum, GLint* value) {
+    record("glGetQueryiv");
+    *value = 0;
+}
+void APIENTRY nullGetProgramInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log) {
+    record("glGetProgramInfoLog");
+    if (length) *length = 0;
+    if (log) log[0] = '\0';
+}
+void APIENTRY nullGetProgramiv(GLuint, GLenum name, GLint* value) {
+    record("glGetProgramiv");
+    *value = name == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+void APIENTRY nullGetShaderInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log) {
+    record("glGetShaderInfoLog");
+    if (length) *length = 0;
+    if (log) log[0] = '\0';
+}
+void APIENTRY nullGetShaderiv(GLuint, GLenum name, GLint* value) {
+    record("glGetShaderiv");
+    *value = name == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+GLint APIENTRY nullGetUniformLocation(GLuint, const GLchar*) {
+    record("glGetUniformLocation");
+    return 0;
+}
+void APIENTRY nullLinkProgram(GLuint) { record("glLinkProgram"); }
+void* APIENTRY nullMapBufferRange(GLenum, GLintptr, GLsizeiptr length, GLbitfield) {
+    record("glMapBufferRange");
+    null_gl_mapped.resize(std::max(null_gl_mapped.size(), (size_t) length));
+    return null_gl_mapped.data();
+}
+void APIENTRY nullPixelStorei(GLenum, GLint) { record("glPixelStorei"); }
+void APIENTRY nullReadPixels(GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, void* pixels) {
+    record("glReadPixels");
+    std::memset(pixels, 0, (size_t) width * height * 4);
+}
+void APIENTRY nullRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei) { record("glRenderbufferStorage"); }
+void APIENTRY nullShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) { record("glShaderSource"); }
+void APIENTRY nullTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) {
+    record("glTexImage2D");
+}
+void APIENTRY nullTexParameteri(GLenum, GLenum, GLint) { record("glTexParameteri"); }
+void APIENTRY nullUniform1f(GLint, GLfloat) { record("glUniform1f"); }
+void APIENTRY nullUniform1i(GLint, GLint) { record("glUniform1i"); }
+void APIENTRY nullUniform3fv(GLint, GLsizei, const GLfloat*) { record("glUniform3fv"); }
+void APIENTRY nullUniform4fv(GLint, GLsizei, const GLfloat*) { record("glUniform4fv"); }
+void APIENTRY nullUniformMatrix3fv(GLint, GLsizei, GLboolean, const GLfloat*) { record("glUniformMatrix3fv"); }
+void APIENTRY nullUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*) { record("glUniformMatrix4fv"); }
+GLboolean APIENTRY nullUnmapBuffer(GLenum) {
+    record("glUnmapBuffer");
+    return GL_TRUE;
+}
+void APIENTRY nullUseProgram(GLuint) { record("glUseProgram"); }
+void APIENTRY nullVertexAttribDivisor(GLuint, GLuint) { record("glVertexAttribDivisor"); }
+void APIENTRY nullVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {
+    record("glVertexAttribPointer");
+}
+void APIENTRY nullViewport(GLint, GLint, GLsizei, GLsizei) { record("glViewport"); }
+}  // namespace
+
+void installNullGL() {
+    // the gl* names are gl3w's function pointer macros, so this swaps what every call site reaches
+    glActiveTexture = nullActiveTexture;
+    glAttachShader = nullAttachShader;
+    glBindBuffer = nullBindBuffer;
+    glBindFramebuffer = nullBindFramebuffer;
+    glBindRenderbuffer = nullBindRenderbuffer;
+    glBindTexture = nullBindTexture;
+    glBindVertexArray = nullBindVertexArray;
+    glBlendFunc = nullBlendFunc;
+    glBufferData = nullBufferData;
+    glBufferSubData = nullBufferSubData;
+    glCheckFramebufferStatus = nullCheckFramebufferStatus;
+    glClear = nullClear;
+    glClearColor = nullClearColor;
+    glClearDepth = nullClearDepth;
+    glCompileShader = nullCompileShader;
+    glCreateProgram = nullCreateProgram;
+    glCreateShader = nullCreateShader;
+    glDebugMessageCallback = nullDebugMessageCallback;
+    glDebugMessageControl = nullDebugMessageControl;
+    glDeleteBuffers = nullDeleteBuffers;
+    glDeleteFramebuffers = nullDeleteFramebuffers;
+    glDeleteProgram = nullDeleteProgram;
+    glDeleteRenderbuffers = nullDeleteRenderbuffers;
+    glDeleteShader = nullDeleteShader;
+    glDeleteTextures = nullDeleteTextures;
+    glDeleteVertexArrays = nullDeleteVertexArrays;
+    glDepthRange = nullDepthRange;
+    glDetachShader = nullDetachShader;
+    glDisable = nullDisable;
+    glDrawArrays = nullDrawArrays;
+    glDrawElements = nullDrawElements;
+    glDrawElementsInstanced = nullDrawElementsInstanced;
+    glEnable = nullEnable;
+    glEnableVertexAttribArray = nullEnableVertexAttribArray;
+    glFramebufferRenderbuffer = nullFramebufferRenderbuffer;
+    glFramebufferTexture = nullFramebufferTexture;
+    glGenBuffers = nullGenBuffers;
+    glGenFramebuffers = nullGenFramebuffers;
+    glGenRenderbuffers = nullGenRenderbuffers;
+    glGenTextures = nullGenTextures;
+    glGenVertexArrays = nullGenVertexArrays;
+    glGetAttribLocation = nullGetAttribLocation;
+    glGetError = nullGetError;
+    glGetIntegerv = nullGetIntegerv;
+    glGetQueryiv = nullGetQueryiv;
+    glGetProgramInfoLog = nullGetProgramInfoLog;
+    glGetProgramiv = nullGetProgramiv;
+    glGetShaderInfoLog = nullGetShaderInfoLog;
+    glGetShaderiv = nullGetShaderiv;
+    glGetUniformLocation = nullGetUniformLocation;
+    glLinkProgram = nullLinkProgram;
+    glMapBufferRange = nullMapBufferRange;
+    glPixelStorei = nullPixelStorei;
+    glReadPixels = nullReadPixels;
+    glRenderbufferStorage = nullRenderbufferStorage;
+    glShaderSource = nullShaderSource;
+    glTexImage2D = nullTexImage2D;
+    glTexParameteri = nullTexParameteri;
+    glUniform1f = nullUniform1f;
+    glUniform1i = nullUniform1i;
+    glUniform3fv = nullUniform3fv;
+    glUniform4fv = nullUniform4fv;
+    glUniformMatrix3fv = nullUniformMatrix3fv;
+    glUniformMatrix4fv = nullUniformMatrix4fv;
+    glUnmapBuffer = nullUnmapBuffer;
+    glUseProgram = nullUseProgram;
+    glVertexAttribDivisor = nullVertexAttribDivisor;
+    glVertexAttribPointer = nullVertexAttribPointer;
+    glViewport = nullViewport;
+}
+
+const std::vector<const char*>& nullGLCommands() {
+    return null_gl_commands;
+}
+
+void clearNullGLCommands() {
+    null_gl_commands.clear();
+}
+
+// ========= PNG =========
+
+namespace {
+uint32_t crc32(const uint8_t* data, size_t n, uint32_t crc = 0) {
+    static std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((uint8_t) (value >> shift));
+}
+
+void writeChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    appendBigEndian(chunk, (uint32_t) data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    file.write((const char*) chunk.data(), chunk.size());
+}
+}  // namespace
+
+bool writePNG(const std::string& path, const uint8_t* rgba, int width, int height) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "ERROR: Could not write " << path << std::endl;
+        return false;
+    }
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    file.write((const char*) signature, sizeof(signature));
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, (uint32_t) width);
+    appendBigEndian(header, (uint32_t) height);
+    header.insert(header.end(), {8, 6, 0, 0, 0});  // 8 bit RGBA, no interlace
+    writeChunk(file, "IHDR", header);
+
+    // every row starts with filter type 0
+    std::vector<uint8_t> raw;
+    size_t row_bytes = (size_t) width * 4;
+    raw.reserve((row_bytes + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * row_bytes, rgba + (y + 1) * row_bytes);
+    }
+
+    // zlib stream of stored blocks, at most 65535 bytes each
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    size_t offset = 0;
+    do {
+        size_t block = std::min(raw.size() - offset, (size_t) 65535);
+        bool last = offset + block == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((uint8_t) block);
+        zlib.push_back((uint8_t) (block >> 8));
+        zlib.push_back((uint8_t) ~block);
+        zlib.push_back((uint8_t) (~block >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + block);
+        offset += block;
+    } while (offset < raw.size());
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+    writeChunk(file, "IDAT", zlib);
+    writeChunk(file, "IEND", {});
+    return (bool) file;
+}
+
+bool writeFramebufferPNG(const std::string& path, int width, int height) {
+    std::vector<uint8_t> pixels((size_t) width * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    gl_has_errors();
+
+    // GL rows start at the bottom, PNG rows at the top
+    size_t row_bytes = (size_t) width * 4;
+    std::vector<uint8_t> flipped(pixels.size());
+    for (int y = 0; y < height; y++) {
+        std::memcpy(&flipped[y * row_bytes], &pixels[(height - 1 - y) * row_bytes], row_bytes);
+    }
+    return writePNG(path, flipped.data(), width, height);
+}
@@ -4,8 +4,12 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/quaternion_common.hpp>
 #include <glm/ext/vector_float3.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/trigonometric.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <iostream>
 #include <memory>
 
@@ -14,16 +18,39 @@
 #include "bnuui/bnuui.hpp"
 #include "camera_system.hpp"
 #include "common.hpp"
+#include "frame_arena.hpp"
 #include "sceneManager/scene_manager.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
 #include "gacha_system.hpp"
+#include "perf_hud.hpp"
+#include "profiler.hpp"
+#include "system_timings.hpp"
 
 bool RenderSystem::isRenderingGacha = false;
 bool RenderSystem::isRenderingBook = false;
 bool RenderSystem::isPaused = false;
 bool RenderSystem::isInGame = false;
 
+const EffectPipeline& RenderSystem::usePipeline(EFFECT_ASSET_ID effect, GEOMETRY_BUFFER_ID geometry) {
+    assert(effect != EFFECT_ASSET_ID::EFFECT_COUNT);
+    assert(geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
+    const EffectPipeline& pipeline = pipelines[(GLuint) effect];
+    gl_state.useProgram(pipeline.program);
+    gl_state.bindVertexArray(geometryVAO(effect, geometry));
+    gl_has_errors();
+    return pipeline;
+}
+
+void RenderSystem::bindSpriteTexture(GLuint texture) {
+    gl_state.activeTexture(GL_TEXTURE0);
+    gl_state.bindTexture2D(texture);
+    // Brian: Disable smoothing
+    gl_state.texParameter(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl_state.texParameter(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl_has_errors();
+}
+
 void RenderSystem::drawGridLine(Entity entity, const mat3& projection) {
     GridLine& gridLine = registry.gridLines.get(entity);
 
@@ -40,71 +67,21 @@ void RenderSystem::drawGridLine(Entity entity, const mat3& projection) {
 
     assert(registry.renderRequests.has(entity));
     const RenderRequest& render_request = registry.renderRequests.get(entity);
+    assert(render_request.used_effect == EFFECT_ASSET_ID::EGG && "Type of render request not supported");
 
-    const GLuint used_effect_enum = (GLuint) render_request.used_effect;
-    assert(used_effect_enum != (GLuint) EFFECT_ASSET_ID::EFFECT_COUNT);
-    const GLuint program = (GLuint) effects[used_effect_enum];
-
-    // setting shaders
-    glUseProgram(program);
-    gl_has_errors();
-
-    assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-    const GLuint vbo = vertex_buffers[(GLuint) render_request.used_geometry];
-    const GLuint ibo = index_buffers[(GLuint) render_request.used_geometry];
-
-    // Setting vertex and index buffers
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    gl_has_errors();
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    gl_has_errors();
-
-    if (render_request.used_effect == EFFECT_ASSET_ID::EGG) {
-        GLint in_position_loc = glGetAttribLocation(program, "in_position");
-        gl_has_errors();
+    // setting shaders and the vertex layout of the geometry
+    const EffectPipeline& pipeline = usePipeline(render_request.used_effect, render_request.used_geometry);
 
-        GLint in_color_loc = glGetAttribLocation(program, "in_color");
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_position_loc);
-        glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) 0);
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_color_loc);
-        glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) sizeof(vec3));
-        gl_has_errors();
-    } else {
-        assert(false && "Type of render request not supported");
-    }
-
-    // Getting uniform locations for glUniform* calls
-    GLint color_uloc = glGetUniformLocation(program, "fcolor");
     const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
     // CK: std::cout << "line color: " << color.r << ", " << color.g << ", " << color.b << std::endl;
-    glUniform3fv(color_uloc, 1, (float*) &color);
-    gl_has_errors();
-
-    // Get number of indices from index buffer, which has elements uint16_t
-    GLint size = 0;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-    gl_has_errors();
-
-    GLsizei num_indices = size / sizeof(uint16_t);
-
-    GLint currProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-    // Setting uniform values to the currently bound program
-    GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-    glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*) &transform.mat);
-    gl_has_errors();
-
-    GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-    glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*) &projection);
+    glUniform3fv(pipeline.fcolor, 1, (float*) &color);
+    glUniformMatrix3fv(pipeline.transform, 1, GL_FALSE, (float*) &transform.mat);
+    glUniformMatrix3fv(pipeline.projection, 1, GL_FALSE, (float*) &projection);
     gl_has_errors();
 
     // Drawing of num_indices/3 triangles specified in the index buffer
-    glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+    glDrawElements(GL_TRIANGLES, index_counts[(GLuint) render_request.used_geometry], GL_UNSIGNED_SHORT, nullptr);
+    frame_stats.draw_calls++;
     gl_has_errors();
 }
 
@@ -120,89 +97,23 @@ void RenderSystem::drawOverlay(Entity entity, const mat3& projection) {
 
     assert(registry.renderRequests.has(entity));
     const RenderRequest& render_request = registry.renderRequests.get(entity);
+    assert(render_request.used_effect == EFFECT_ASSET_ID::ALPHA && "Type of render request not supported");
 
-    const GLuint used_effect_enum = (GLuint) render_request.used_effect;
-    assert(used_effect_enum != (GLuint) EFFECT_ASSET_ID::EFFECT_COUNT);
-    const GLuint program = (GLuint) effects[used_effect_enum];
-
-    // setting shaders
-    glUseProgram(program);
-    gl_has_errors();
-
-    assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-    const GLuint vbo = vertex_buffers[(GLuint) render_request.used_geometry];
-    const GLuint ibo = index_buffers[(GLuint) render_request.used_geometry];
-
-    // Setting vertex and index buffers
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    gl_has_errors();
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    gl_has_errors();
-
-    if (render_request.used_effect == EFFECT_ASSET_ID::ALPHA) {
-        GLint in_position_loc = glGetAttribLocation(program, "in_position");
-        gl_has_errors();
-
-        GLint in_color_loc = glGetAttribLocation(program, "in_color");
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_position_loc);
-        glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) 0);
-        gl_has_errors();
+    const EffectPipeline& pipeline = usePipeline(render_request.used_effect, render_request.used_geometry);
 
-        glEnableVertexAttribArray(in_color_loc);
-        glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) sizeof(vec3));
-        gl_has_errors();
-    } else {
-        assert(false && "Type of render request not supported");
-    }
-
-    // Getting uniform locations for glUniform* calls
-    GLint color_uloc = glGetUniformLocation(program, "fcolor");
     const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
-    // CK: std::cout << "line color: " << color.r << ", " << color.g << ", " << color.b << std::endl;
-    glUniform3fv(color_uloc, 1, (float*) &color);
-    gl_has_errors();
-
-    GLint alpha_uloc = glGetUniformLocation(program, "alpha");
-    glUniform1f(alpha_uloc, overlay.alpha);
-    gl_has_errors();
-
-    GLint visible_uloc = glGetUniformLocation(program, "visible");
-    glUniform1i(visible_uloc, overlay.visible);
-    gl_has_errors();
-
-    GLint hl_count_uloc = glGetUniformLocation(program, "num_centers");
-    glUniform1i(hl_count_uloc, highlight_count);
-    gl_has_errors();
-
-    GLint centers_uloc = glGetUniformLocation(program, "centers");
-    glUniform3fv(centers_uloc, 5, value_ptr(highlight_centers[0]));
-    gl_has_errors();
-
-
-
-    // Get number of indices from index buffer, which has elements uint16_t
-    GLint size = 0;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-    gl_has_errors();
-
-    GLsizei num_indices = size / sizeof(uint16_t);
-
-    GLint currProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-    // Setting uniform values to the currently bound program
-    GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-    glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*) &transform.mat);
-    gl_has_errors();
-
-    GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-    glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*) &projection);
+    glUniform3fv(pipeline.fcolor, 1, (float*) &color);
+    glUniform1f(pipeline.alpha, overlay.alpha);
+    glUniform1i(pipeline.visible, overlay.visible);
+    glUniform1i(pipeline.num_centers, highlight_count);
+    glUniform3fv(pipeline.centers, 5, value_ptr(highlight_centers[0]));
+    glUniformMatrix3fv(pipeline.transform, 1, GL_FALSE, (float*) &transform.mat);
+    glUniformMatrix3fv(pipeline.projection, 1, GL_FALSE, (float*) &projection);
     gl_has_errors();
 
     // Drawing of num_indices/3 triangles specified in the index buffer
-    glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+    glDrawElements(GL_TRIANGLES, index_counts[(GLuint) render_request.used_geometry], GL_UNSIGNED_SHORT, nullptr);
+    frame_stats.draw_calls++;
     gl_has_errors();
 }
 
@@ -225,146 +136,53 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3& projection) {
     assert(registry.renderRequests.has(entity));
     const RenderRequest& render_request = registry.renderRequests.get(entity);
 
-    const GLuint used_effect_enum = (GLuint) render_request.used_effect;
-    assert(used_effect_enum != (GLuint) EFFECT_ASSET_ID::EFFECT_COUNT);
-    const GLuint program = (GLuint) effects[used_effect_enum];
-
-    // Setting shaders
-    glUseProgram(program);
-    gl_has_errors();
-
-    assert(render_request.used_geometry != GEOMETRY_BUFFER_ID::GEOMETRY_COUNT);
-    const GLuint vbo = vertex_buffers[(GLuint) render_request.used_geometry];
-    const GLuint ibo = index_buffers[(GLuint) render_request.used_geometry];
-
-    // Setting vertex and index buffers
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    gl_has_errors();
+    // Setting shaders and the vertex layout of the geometry
+    const EffectPipeline& pipeline = usePipeline(render_request.used_effect, render_request.used_geometry);
 
-    // texture-mapped entities - use data location as in the vertex buffer
+    // texture-mapped entities
     if (render_request.used_effect == EFFECT_ASSET_ID::TEXTURED) {
-        GLint in_position_loc = glGetAttribLocation(program, "in_position");
-        GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-        gl_has_errors();
-        assert(in_texcoord_loc >= 0);
-
-        glEnableVertexAttribArray(in_position_loc);
-        glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*) 0);
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_texcoord_loc);
-        glVertexAttribPointer(in_texcoord_loc,
-                              2,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              sizeof(TexturedVertex),
-                              (void*) sizeof(vec3));  // note the stride to skip the preceeding vertex position
-
-        // Enabling and binding texture to slot 0
-        glActiveTexture(GL_TEXTURE0);
-        gl_has_errors();
-
-        assert(registry.renderRequests.has(entity));
-        GLuint texture_id = texture_gl_handles[(GLuint) registry.renderRequests.get(entity).used_texture];
-
-        glBindTexture(GL_TEXTURE_2D, texture_id);
-        // Brian: Disable smoothing
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        bindSpriteTexture(texture_gl_handles[(GLuint) render_request.used_texture]);
 
+        // the texture may be a region of an atlas page
+        glUniform4fv(pipeline.uv_rect, 1, (float*) &texture_uv_rects[(GLuint) render_request.used_texture]);
         gl_has_errors();
     }
     // .obj entities
-    else if (render_request.used_effect == EFFECT_ASSET_ID::CHICKEN ||
-             render_request.used_effect == EFFECT_ASSET_ID::EGG) {
-        GLint in_position_loc = glGetAttribLocation(program, "in_position");
-        GLint in_color_loc = glGetAttribLocation(program, "in_color");
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_position_loc);
-        glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) 0);
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_color_loc);
-        glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) sizeof(vec3));
-        gl_has_errors();
-    } else {
+    else if (render_request.used_effect != EFFECT_ASSET_ID::CHICKEN &&
+             render_request.used_effect != EFFECT_ASSET_ID::EGG) {
         assert(false && "Type of render request not supported");
     }
 
-    // Getting uniform locations for glUniform* calls
-    GLint color_uloc = glGetUniformLocation(program, "fcolor");
     const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
-    glUniform3fv(color_uloc, 1, (float*) &color);
-    gl_has_errors();
-
-    // Get number of indices from index buffer, which has elements uint16_t
-    GLint size = 0;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-    gl_has_errors();
-
-    GLsizei num_indices = size / sizeof(uint16_t);
-    // GLsizei num_triangles = num_indices / 3;
-
-    GLint currProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
-    // Setting uniform values to the currently bound program
-    GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-    glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*) &transform.mat);
-    gl_has_errors();
-
-    GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
-    glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*) &projection);
+    glUniform3fv(pipeline.fcolor, 1, (float*) &color);
+    glUniformMatrix3fv(pipeline.transform, 1, GL_FALSE, (float*) &transform.mat);
+    glUniformMatrix3fv(pipeline.projection, 1, GL_FALSE, (float*) &projection);
     gl_has_errors();
 
     // Drawing of num_indices/3 triangles specified in the index buffer
-    glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+    glDrawElements(GL_TRIANGLES, index_counts[(GLuint) render_request.used_geometry], GL_UNSIGNED_SHORT, nullptr);
+    frame_stats.draw_calls++;
     gl_has_errors();
 }
 
 void RenderSystem::drawUIElement(bnuui::Element& element, const mat3& projection) {
     if (!element.visible) return;
 
-    glm::mat4 UI_Matrix = mat4(1.0f);
-
     Transform transform;
     transform.translate(element.position);
     transform.scale(element.scale);
     transform.rotate(radians(element.rotation));
 
-    const GLuint program = (GLuint) effects[(GLuint) element.effect];
-    glUseProgram(program);
-    gl_has_errors();
-
-    const GLuint vbo = vertex_buffers[(GLuint) element.geometry];
-    const GLuint ibo = index_buffers[(GLuint) element.geometry];
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    gl_has_errors();
+    const EffectPipeline& pipeline = usePipeline(element.effect, element.geometry);
 
     // Texture handling
     if (element.effect == EFFECT_ASSET_ID::TEXTURED) {
-        GLint in_position_loc = glGetAttribLocation(program, "in_position");
-        GLint in_texcoord_loc = glGetAttribLocation(program, "in_texcoord");
-        
         // Check if attribute locations are valid
-        if (in_position_loc < 0 || in_texcoord_loc < 0) {
+        if (pipeline.in_position < 0 || pipeline.in_texcoord < 0) {
             std::cerr << "Error: Failed to get attribute locations in UI element shader" << std::endl;
             return;
         }
-        
-        glEnableVertexAttribArray(in_position_loc);
-        glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*) 0);
-        gl_has_errors();
 
-        glEnableVertexAttribArray(in_texcoord_loc);
-        glVertexAttribPointer(in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*) sizeof(vec3));
-        gl_has_errors();
-
-        glActiveTexture(GL_TEXTURE0);
-        gl_has_errors();
-        
         // Validate texture index
         if ((GLuint)element.texture >= texture_gl_handles.size()) {
             std::cerr << "Error: Invalid texture index: " << (GLuint)element.texture 
@@ -380,105 +198,226 @@ void RenderSystem::drawUIElement(bnuui::Element& element, const mat3& projection
             return;
         }
         
-        glBindTexture(GL_TEXTURE_2D, texture_id);
-        // Brian: Disable smoothing
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    } else {
-        GLint in_position_loc = glGetAttribLocation(program, "in_position");
-        GLint in_color_loc = glGetAttribLocation(program, "in_color");
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_position_loc);
-        glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) 0);
-        gl_has_errors();
-
-        glEnableVertexAttribArray(in_color_loc);
-        glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*) sizeof(vec3));
+        bindSpriteTexture(texture_id);
+        glUniform4fv(pipeline.uv_rect, 1, (float*) &texture_uv_rects[(GLuint) element.texture]);
         gl_has_errors();
     }
 
-    // Set color uniform
-    GLint color_uloc = glGetUniformLocation(program, "fcolor");
-    glUniform3fv(color_uloc, 1, (float*) &element.color);
-    gl_has_errors();
-
-    // Set transformation uniforms
-    GLuint transform_loc = glGetUniformLocation(program, "transform");
-    glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*) &transform.mat);
-    gl_has_errors();
-
-    GLuint projection_loc = glGetUniformLocation(program, "projection");
-    glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*) &projection);
+    // Set color and transformation uniforms
+    glUniform3fv(pipeline.fcolor, 1, (float*) &element.color);
+    glUniformMatrix3fv(pipeline.transform, 1, GL_FALSE, (float*) &transform.mat);
+    glUniformMatrix3fv(pipeline.projection, 1, GL_FALSE, (float*) &projection);
     gl_has_errors();
 
     // Draw the UI element
-    GLint size = 0;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-    GLsizei num_indices = size / sizeof(uint16_t);
-    glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+    glDrawElements(GL_TRIANGLES, index_counts[(GLuint) element.geometry], GL_UNSIGNED_SHORT, nullptr);
+    frame_stats.draw_calls++;
     gl_has_errors();
 
     // Recursively draw children
     for (auto& child : element.children) {
-        if (child->getText() == "")
+        if (!child->hasText())
             drawUIElement(*child, projection);
         else 
-            renderText(child->getText(), child->position.x, WINDOW_HEIGHT_PX - child->position.y, child->getFontSize(), child->color, UI_Matrix);
+            renderText(*child);
     }
 }
 
 
-void RenderSystem::drawParticles(Entity entity, const mat3& projection) {
-    ParticleEmitter& emitter = registry.particleEmitters.get(entity); 
+namespace {
+// The unit quad is rotated before it is scaled, so any rotation stays inside the circle around
+// a square of the larger scale. Background objects live in world space and are shifted by the
+// camera like in drawTexturedMesh.
+bool isInView(vec2 position, vec2 scale, bool background) {
+    if (background) position += CameraSystem::GetInstance()->position;
+    float radius = 0.5f * glm::root_two<float>() * std::max(std::abs(scale.x), std::abs(scale.y)) + VIEW_CULL_MARGIN_PX;
+    return position.x + radius >= 0.f && position.x - radius <= WINDOW_WIDTH_PX && position.y + radius >= 0.f &&
+           position.y - radius <= WINDOW_HEIGHT_PX;
+}
+}  // namespace
+
+void RenderSystem::drawParticles(const mat3& projection) {
+    particle_instances.clear();
+    for (Entity entity : registry.particleEmitters.entities) {
+        ParticleEmitter& emitter = registry.particleEmitters.get(entity);
+        bool background = registry.backgroundObjects.has(entity);
+        vec2 offset = background ? CameraSystem::GetInstance()->position : vec2(0.f);
+
+        // colors and sizes follow from the particle's age, only the live range is visited
+        const ParticlePool& pool = emitter.particles;
+        const ParticleProps& props = emitter.props;
+        for (size_t i = 0; i < pool.count; i++) {
+            float life = pool.life_remaining[i] / props.LifeTime;
+            vec2 position = {pool.position_x[i], pool.position_y[i]};
+            float size = glm::mix(props.SizeEnd, pool.size_begin[i], life) * 10.0f;
+            if (!isInView(position, vec2(size), background)) {
+                frame_stats.particles_culled++;
+                continue;
+            }
+
+            vec4 color = glm::mix(props.ColorEnd, props.ColorBegin, life);
+            particle_instances.push_back({position + offset, size, pool.rotation[i], color});
+        }
+    }
+
+    // Determine the number of instances.
+    size_t instance_count = particle_instances.size();
+    frame_stats.particles_drawn += (int) instance_count;
+    if (instance_count == 0)
+        return;
+
+    gl_state.bindVertexArray(m_QuadVAO);
+    gl_state.bindArrayBuffer(m_particle_instance_VBO);
+
+    // When the ring is full start over in fresh storage, growing it if one frame does not fit.
+    // The driver keeps the orphaned storage alive for the draws still reading it.
+    if (particle_ring_offset + instance_count > particle_buffer_capacity) {
+        while (particle_buffer_capacity < instance_count) particle_buffer_capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, particle_buffer_capacity * sizeof(ParticleInstance), nullptr, GL_STREAM_DRAW);
+        particle_ring_offset = 0;
+    }
+
+    // nothing in flight reads this range since the last orphaning, so the write needs no sync
+    const size_t first = particle_ring_offset * sizeof(ParticleInstance);
+    const size_t bytes = instance_count * sizeof(ParticleInstance);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER,
+                                    first,
+                                    bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (mapped) {
+        memcpy(mapped, particle_instances.data(), bytes);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, first, bytes, particle_instances.data());
+    }
+    particle_ring_offset += instance_count;
+    gl_has_errors();
+
+    // GL 3.3 has no base instance, point the instance attributes at this frame's slice of the ring
+    const GLsizei stride = sizeof(ParticleInstance);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*) (first + offsetof(ParticleInstance, position)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*) (first + offsetof(ParticleInstance, color)));
+    gl_has_errors();
+
+    // every emitter blends the same way, so all of them go out in a single draw
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glUseProgram(m_Particle_shaderProgram);
+    gl_state.useProgram(m_Particle_shaderProgram);
     glUniformMatrix3fv(m_ParticleShaderViewProj, 1, GL_FALSE, (float*)&projection);
 
-    std::vector<mat3> transforms;
-    std::vector<vec4> colors;
+    // INSTANCE RENDERING: LOOK HERE TA THIS IS THE CODE!!!!
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, (GLsizei) instance_count);
+    frame_stats.draw_calls++;
+    gl_has_errors();
+}
 
-    for (auto& particle : emitter.particles) {
-        if (!particle.Active)
-            continue;
+namespace {
+uint64_t renderSortKey(int layer, EFFECT_ASSET_ID effect, GLuint texture, uint32_t sequence) {
+    return ((uint64_t) (layer & 0xff) << 56) | ((uint64_t) ((int) effect & 0xff) << 48) |
+           ((uint64_t) (texture & 0xffff) << 32) | sequence;
+}
+}  // namespace
 
-        float life = particle.LifeRemaining / particle.LifeTime;
-        vec4 color = glm::mix(particle.ColorEnd, particle.ColorBegin, life);
-        float size = glm::mix(particle.SizeEnd, particle.SizeBegin, life);
+namespace {
+uint16_t toUnorm16(float value) {
+    return (uint16_t) (glm::clamp(value, 0.f, 1.f) * 65535.f + 0.5f);
+}
 
-        Transform transform;
-        if (registry.backgroundObjects.has(entity)) {
-            transform.translate(particle.Position + CameraSystem::GetInstance()->position);
-        } else {
-            transform.translate(particle.Position);
-        }
-        transform.rotate(particle.Rotation);
-        transform.scale({ size * 10.0f, size * 10.0f });
+uint8_t toUnorm8(float value) {
+    return (uint8_t) (glm::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+}
+}  // namespace
 
-        transforms.push_back(transform.mat);
-        colors.push_back(color);
-    }
+// Motion is copied as is, the vertex shader applies the same translate * scale * rotate as drawTexturedMesh
+void RenderSystem::pushSprite(Entity entity, const vec4& uv_rect) {
+    const Motion& motion = registry.motions.get(entity);
+    const vec3 color = registry.colors.has(entity) ? registry.colors.get(entity) : vec3(1);
 
-    // Determine the number of instances.
-    unsigned int instanceCount = transforms.size();
-    if (instanceCount == 0)
-        return;
+    SpriteInstance instance;
+    instance.position = motion.position;
+    if (registry.backgroundObjects.has(entity)) instance.position += CameraSystem::GetInstance()->position;
+    instance.scale = motion.scale;
+    instance.angle = motion.angle;
+    for (int i = 0; i < 4; i++) instance.uv_rect[i] = toUnorm16(uv_rect[i]);
+    instance.tint[0] = toUnorm8(color.r);
+    instance.tint[1] = toUnorm8(color.g);
+    instance.tint[2] = toUnorm8(color.b);
+    instance.tint[3] = 255;
+    sprite_instances.push_back(instance);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceTransformVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(mat3), transforms.data());
+void RenderSystem::drawSpriteRun(const SpriteRun& run, const mat3& projection) {
+    const EffectPipeline& pipeline = pipelines[(GLuint) EFFECT_ASSET_ID::SPRITE_BATCH];
+    gl_state.useProgram(pipeline.program);
+    glUniformMatrix3fv(pipeline.projection, 1, GL_FALSE, (float*) &projection);
+    gl_has_errors();
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceColorVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(vec4), colors.data());
+    bindSpriteTexture(run.texture);
 
-    glBindVertexArray(m_QuadVAO);
+    // GL 3.3 has no base instance, point the instance attributes at the first instance of the run
+    gl_state.bindVertexArray(m_sprite_batch_VAO);
+    gl_state.bindArrayBuffer(m_sprite_instance_VBO);
+    const size_t first = run.first_sprite * sizeof(SpriteInstance);
+    const GLsizei stride = sizeof(SpriteInstance);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*) (first + offsetof(SpriteInstance, position)));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*) (first + offsetof(SpriteInstance, scale)));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*) (first + offsetof(SpriteInstance, angle)));
+    glVertexAttribPointer(
+        5, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*) (first + offsetof(SpriteInstance, uv_rect)));
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*) (first + offsetof(SpriteInstance, tint)));
+    gl_has_errors();
 
-    // INSTANCE RENDERING: LOOK HERE TA THIS IS THE CODE!!!!
-    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, instanceCount);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, (GLsizei) run.sprite_count);
+    frame_stats.draw_calls++;
+    gl_has_errors();
+}
+
+// Textured sprites become instances in sorted order, and consecutive instances sharing a GL texture
+// (an atlas page for most sprites) are one instanced draw. Anything else (grid lines, meshes) breaks
+// the run and is drawn as before.
+void RenderSystem::drawRenderCommands(const mat3& projection) {
+    sprite_instances.clear();
+    sprite_runs.clear();
+    for (const RenderCommand& command : render_commands) {
+        Entity entity = command.entity;
+        const RenderRequest& render_request = registry.renderRequests.get(entity);
+        bool batched = render_request.used_effect == EFFECT_ASSET_ID::TEXTURED &&
+                       render_request.used_geometry == GEOMETRY_BUFFER_ID::SPRITE && registry.motions.has(entity);
+        if (!batched) {
+            sprite_runs.push_back({0, 0, 0, entity, false});
+            continue;
+        }
+
+        GLuint texture = texture_gl_handles[(GLuint) render_request.used_texture];
+        if (sprite_runs.empty() || !sprite_runs.back().batched || sprite_runs.back().texture != texture) {
+            sprite_runs.push_back({sprite_instances.size(), 0, texture, entity, true});
+        }
+        sprite_runs.back().sprite_count++;
+        pushSprite(entity, texture_uv_rects[(GLuint) render_request.used_texture]);
+    }
+
+    // orphan the previous frame's storage and upload every instance at once
+    size_t sprite_count = sprite_instances.size();
+    if (sprite_count > 0) {
+        growSpriteBatch(sprite_count);
+        gl_state.bindArrayBuffer(m_sprite_instance_VBO);
+        glBufferData(GL_ARRAY_BUFFER, sprite_batch_capacity * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sprite_count * sizeof(SpriteInstance), sprite_instances.data());
+        gl_has_errors();
+    }
 
-    glBindVertexArray(m_VAO);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    for (const SpriteRun& run : sprite_runs) {
+        if (run.batched) {
+            drawSpriteRun(run, projection);
+            frame_stats.sprite_runs++;
+        } else if (registry.motions.has(run.entity)) {
+            drawTexturedMesh(run.entity, projection);
+        } else {
+            drawGridLine(run.entity, projection);
+        }
+    }
+    frame_stats.sprites += (int) sprite_count;
 }
 
 // first draw to an intermediate texture,
@@ -487,16 +426,12 @@ void RenderSystem::drawParticles(Entity entity, const mat3& projection) {
 void RenderSystem::drawToScreen() {
     // Setting shaders
     // get the vignette texture, sprite mesh, and program
-    glUseProgram(effects[(GLuint) EFFECT_ASSET_ID::VIGNETTE]);
-    gl_has_errors();
+    const EffectPipeline& pipeline = usePipeline(EFFECT_ASSET_ID::VIGNETTE, GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE);
 
     // Clearing backbuffer
-    int w, h;
-    glfwGetFramebufferSize(window,
-                           &w,
-                           &h);  // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, w, h);
+    ivec2 size = getFramebufferSize();
+    glBindFramebuffer(GL_FRAMEBUFFER, screen_frame_buffer);
+    glViewport(0, 0, size.x, size.y);
     glDepthRange(0, 10);
     glClearColor(1.f, 0, 0, 1.0);
     glClearDepth(1.f);
@@ -507,40 +442,19 @@ void RenderSystem::drawToScreen() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDisable(GL_DEPTH_TEST);
 
-    // Draw the screen texture on the quad geometry
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint) GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);
-    glBindBuffer(
-        GL_ELEMENT_ARRAY_BUFFER,
-        index_buffers[(GLuint) GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE]);  // Note, GL_ELEMENT_ARRAY_BUFFER associates
-                                                                       // indices to the bound GL_ARRAY_BUFFER
-    gl_has_errors();
-
     // add the "vignette" effect
-    const GLuint vignette_program = effects[(GLuint) EFFECT_ASSET_ID::VIGNETTE];
-
     // set clock
-    GLuint time_uloc = glGetUniformLocation(vignette_program, "time");
-    GLuint dead_timer_uloc = glGetUniformLocation(vignette_program, "darken_screen_factor");
-
-    glUniform1f(time_uloc, (float) (glfwGetTime() * 10.0f));
+    glUniform1f(pipeline.time, (float) (glfwGetTime() * 10.0f));
 
     ScreenState& screen = registry.screenStates.get(screen_state_entity);
     // std::cout << "screen.darken_screen_factor: " << screen.darken_screen_factor << " entity id: " <<
     // screen_state_entity << std::endl;
-    glUniform1f(dead_timer_uloc, screen.darken_screen_factor);
-    gl_has_errors();
-
-    // Set the vertex position and vertex texture coordinates (both stored in the
-    // same VBO)
-    GLint in_position_loc = glGetAttribLocation(vignette_program, "in_position");
-    glEnableVertexAttribArray(in_position_loc);
-    glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*) 0);
+    glUniform1f(pipeline.darken_screen_factor, screen.darken_screen_factor);
     gl_has_errors();
 
     // Bind our texture in Texture Unit 0
-    glActiveTexture(GL_TEXTURE0);
-
-    glBindTexture(GL_TEXTURE_2D, off_screen_render_buffer_color);
+    gl_state.activeTexture(GL_TEXTURE0);
+    gl_state.bindTexture2D(off_screen_render_buffer_color);
     gl_has_errors();
 
     // Draw
@@ -549,6 +463,7 @@ void RenderSystem::drawToScreen() {
                    GL_UNSIGNED_SHORT,
                    nullptr);  // one triangle = 3 vertices; nullptr indicates that there is
                               // no offset from the bound index buffer
+    frame_stats.draw_calls++;
     gl_has_errors();
 }
 
@@ -556,11 +471,19 @@ void RenderSystem::drawToScreen() {
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
 void RenderSystem::draw() {
+    PROFILE_ZONE("render.draw");
+    ScopedAllocationZone allocation_zone(render_allocation_zone);
+    auto frame_start = std::chrono::high_resolution_clock::now();
+    frame_stats = RenderStats();
+    // anything outside of draw() may have changed the bindings since last frame
+    gl_state.invalidate();
+    gl_state.resetCounters();
+    gpu_timer.beginFrame();
+
     // Getting size of window
-    int w, h;
-    glfwGetFramebufferSize(window,
-                           &w,
-                           &h);  // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+    ivec2 size = getFramebufferSize();
+    int w = size.x;
+    int h = size.y;
 
     // First render to the custom framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
@@ -581,19 +504,16 @@ void RenderSystem::draw() {
                                // and alpha blending, one would have to sort
                                // sprites back to front
     gl_has_errors();
+    gpu_timer.endPass(GPU_PASS::CLEAR);
 
     mat3 projection_2D = createProjectionMatrix();
-    glm::mat4 UI_Matrix = mat4(1.0f);
-
-    // Render Disaster whirlpool
-    for (Entity entity : registry.disasters.entities) {
-        if (registry.disasters.get(entity).type == DISASTER_TYPE::WHIRLPOOL)
-            drawTexturedMesh(entity, projection_2D);
-    }
 
+    PROFILE_ZONE_NAMED(collect_zone, "render.collect");
     highlight_count = 0;
-    // draw all entities with a render request to the frame buffer
-    for (Entity entity : registry.renderRequests.entities) {
+    // collect a command for every entity with a render request, then draw them sorted by layer
+    render_commands.clear();
+    for (uint i = 0; i < registry.renderRequests.entities.size(); i++) {
+        Entity entity = registry.renderRequests.entities[i];
         if (registry.spotlights.has(entity)) {
             float diagonal = sqrt(WINDOW_WIDTH_PX * WINDOW_WIDTH_PX + WINDOW_HEIGHT_PX * WINDOW_HEIGHT_PX);
             float rad = registry.spotlights.get(entity).radius / diagonal;
@@ -623,38 +543,71 @@ void RenderSystem::draw() {
                 if (registry.bunnies.get(entity).on_module) continue;
             }
 
-            // Note, its not very efficient to access elements indirectly via the entity
-            // albeit iterating through all Sprites in sequence. A good point to optimize
-            drawTexturedMesh(entity, projection_2D);
+            // off-screen entities never get a command
+            const Motion& motion = registry.motions.get(entity);
+            if (!isInView(motion.position, motion.scale, registry.backgroundObjects.has(entity))) {
+                frame_stats.draws_culled++;
+                continue;
+            }
         }
-        // draw grid lines separately, as they do not have motion but need to be rendered
-        else if (registry.gridLines.has(entity)) {
-            drawGridLine(entity, projection_2D);
+        // grid lines do not have motion but need to be rendered
+        else if (!registry.gridLines.has(entity)) {
+            continue;
         }
-    }
 
-    for (Entity e : registry.particleEmitters.entities) {
-        drawParticles(e, projection_2D);
+        const RenderRequest& render_request = registry.renderRequests.components[i];
+        int layer = registry.renderLayers.has(entity) ? registry.renderLayers.get(entity).layer : RENDER_LAYER_UNITS;
+        GLuint texture = render_request.used_texture == TEXTURE_ASSET_ID::TEXTURE_COUNT
+                             ? 0
+                             : texture_gl_handles[(GLuint) render_request.used_texture];
+        render_commands.push_back({renderSortKey(layer, render_request.used_effect, texture, i), entity});
+        frame_stats.draws_submitted++;
     }
+    std::sort(render_commands.begin(), render_commands.end(), [](const RenderCommand& a, const RenderCommand& b) {
+        return a.key < b.key;
+    });
+    PROFILE_ZONE_END(collect_zone);
+
+    PROFILE_ZONE_NAMED(sprites_zone, "render.sprites");
+    drawRenderCommands(projection_2D);
+    gpu_timer.endPass(GPU_PASS::SPRITES);
+    PROFILE_ZONE_END(sprites_zone);
+
+    PROFILE_ZONE_NAMED(particles_zone, "render.particles");
+    drawParticles(projection_2D);
+    gpu_timer.endPass(GPU_PASS::PARTICLES);
+    PROFILE_ZONE_END(particles_zone);
 
     // Render Disaster tornado above bg/islands/enemies
+    PROFILE_ZONE_NAMED(tornado_zone, "render.tornadoes");
     for (Entity entity : registry.disasters.entities) {
         if (registry.disasters.get(entity).type == DISASTER_TYPE::TORNADO) {
+            const Motion& motion = registry.motions.get(entity);
+            if (!isInView(motion.position, motion.scale, registry.backgroundObjects.has(entity))) {
+                frame_stats.draws_culled++;
+                continue;
+            }
             drawTexturedMesh(entity, projection_2D);
+            frame_stats.draws_submitted++;
         }
     }
 
+    gpu_timer.endPass(GPU_PASS::TORNADOES);
+    PROFILE_ZONE_END(tornado_zone);
+
     // Brian: Add draw UI components here.
+    PROFILE_ZONE_NAMED(ui_zone, "render.ui");
     SceneManager& sm = SceneManager::getInstance();
     Scene* s = sm.getCurrentScene();
     if (s) {
-        bnuui::SceneUI scene_ui = s->getUIElems();
+        bnuui::SceneUI& scene_ui = s->getUIElems();
         if (!isPaused) {
-            std::vector<std::shared_ptr<bnuui::Element>> elems = scene_ui.getElems();
-			for (std::shared_ptr<bnuui::Element> elem : elems) {
+            FrameVector<std::shared_ptr<bnuui::Element>> ui_elems;
+            scene_ui.collectElems(ui_elems);
+			for (const std::shared_ptr<bnuui::Element>& elem : ui_elems) {
         if (elem->over_overlay) continue; // skip the ones above overlay
-				if (elem->getText() != "") {
-					renderText(elem->getText(), elem->position.x, WINDOW_HEIGHT_PX - elem->position.y, elem->getFontSize(), elem->color, UI_Matrix);
+				if (elem->hasText()) {
+					renderText(*elem);
 				} else {
 					drawUIElement(*elem, projection_2D);
 				}
@@ -665,6 +618,12 @@ void RenderSystem::draw() {
         }
     }
 
+    // all text queued under the overlay goes out in one draw
+    flushText();
+    gpu_timer.endPass(GPU_PASS::UI);
+    PROFILE_ZONE_END(ui_zone);
+
+    PROFILE_ZONE_NAMED(overlay_zone, "render.overlay");
     if (registry.overlays.components.size() > 0) {
         Entity overlay_entity = registry.overlays.entities[0];
         if (registry.renderRequests.has(overlay_entity)) {
@@ -684,27 +643,31 @@ void RenderSystem::draw() {
         }
     }
 
+    gpu_timer.endPass(GPU_PASS::OVERLAY);
+    PROFILE_ZONE_END(overlay_zone);
+
     // Dayshaun: draw the UI elements over the shaded overlay
+    PROFILE_ZONE_NAMED(ui_over_overlay_zone, "render.ui_over_overlay");
     if (s) {
-        bnuui::SceneUI scene_ui = s->getUIElems();
-        std::vector<std::shared_ptr<bnuui::Element>> elems = scene_ui.getElems();
-        for (std::shared_ptr<bnuui::Element> elem : elems) {
+        bnuui::SceneUI& scene_ui = s->getUIElems();
+        FrameVector<std::shared_ptr<bnuui::Element>> ui_elems;
+        scene_ui.collectElems(ui_elems);
+        for (const std::shared_ptr<bnuui::Element>& elem : ui_elems) {
             if (!elem->over_overlay) continue; // skip the ones under overlay
-            if (elem->getText() != "") {
-                renderText(elem->getText(),
-                           elem->position.x,
-                           WINDOW_HEIGHT_PX - elem->position.y,
-                           elem->getFontSize(),
-                           elem->color,
-                           UI_Matrix);
+            if (elem->hasText()) {
+                renderText(*elem);
             } else {
                 drawUIElement(*elem, projection_2D);
             }
         }
     }
+    flushText();
+    gpu_timer.endPass(GPU_PASS::UI_OVER_OVERLAY);
+    PROFILE_ZONE_END(ui_over_overlay_zone);
   
     // if there is no gacha ui displayed
     // std::cout << "Gacha rendering? " << isRenderingGacha<< std::endl; 
+    PROFILE_ZONE_NAMED(player_zone, "render.player");
     if(!isRenderingGacha && !isRenderingBook){
         // Render Player.
         for (Entity entity : registry.players.entities) {
@@ -712,15 +675,48 @@ void RenderSystem::draw() {
                 drawTexturedMesh(entity, projection_2D);
         }
     }
-
+    gpu_timer.endPass(GPU_PASS::PLAYER);
+    PROFILE_ZONE_END(player_zone);
+
+    // debug overlay above everything, its draws count towards this frame's statistics
+    PerfHud& perf_hud = PerfHud::getInstance();
+    if (perf_hud.isVisible()) {
+        PROFILE_ZONE("render.perf_hud");
+        for (const std::shared_ptr<bnuui::Element>& elem : perf_hud.getElems()) {
+            if (elem->hasText()) {
+                renderText(*elem);
+            } else {
+                drawUIElement(*elem, projection_2D);
+            }
+        }
+        flushText();
+    }
+    gpu_timer.endPass(GPU_PASS::PERF_HUD);
+    endTextFrame();
 
     // draw framebuffer to screen
     // adding "vignette" effect when applied
+    PROFILE_ZONE_NAMED(present_zone, "render.present");
     drawToScreen();
+    gpu_timer.endPass(GPU_PASS::PRESENT);
+    gpu_timer.endFrame();
+
+    auto frame_end = std::chrono::high_resolution_clock::now();
+    frame_stats.cpu_ms =
+        (float) (std::chrono::duration_cast<std::chrono::microseconds>(frame_end - frame_start)).count() / 1000;
+    frame_stats.gl_calls_issued = gl_state.issuedCalls();
+    frame_stats.gl_calls_elided = gl_state.elidedCalls();
+
+    if (!frame_dump_path.empty()) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, screen_frame_buffer);
+        writeFramebufferPNG(frame_dump_path, size.x, size.y);
+        frame_dump_path.clear();
+    }
 
     // flicker-free display with a double buffer
-    glfwSwapBuffers(window);
+    if (window != nullptr) glfwSwapBuffers(window);
     gl_has_errors();
+    PROFILE_ZONE_END(present_zone);
 }
 
 mat4 RenderSystem::createUIMatrix() {
@@ -742,30 +738,19 @@ mat3 RenderSystem::createProjectionMatrix() {
     return {{sx, 0.f, 0.f}, {0.f, sy, 0.f}, {tx, ty, 1.f}};
 }
 
-void RenderSystem::renderText(std::string text, float x, float y, float scale, const glm::vec3& color, const glm::mat4& trans) {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // activate corresponding render state
-    glUseProgram(m_font_shaderProgram);
-
-    GLint textColor_location = glGetUniformLocation(m_font_shaderProgram, "textColor");
-    assert(textColor_location > -1);
-    // std::cout << "textColor_location: " << textColor_location << std::endl;
-    glUniform3f(textColor_location, color.x, color.y, color.z);
-
-    auto transformLoc = glGetUniformLocation(m_font_shaderProgram, "transform");
-    // std::cout << "transformLoc: " << transformLoc << std::endl;
-    assert(transformLoc > -1);
-    glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(trans));
-
-    glBindVertexArray(m_font_VAO);
-
+void RenderSystem::layoutText(const std::string& text,
+                              float x,
+                              float y,
+                              float scale,
+                              const glm::vec3& color,
+                              const glm::mat4& trans,
+                              std::vector<TextVertex>& vertices) {
     // iterate through each character
     std::string::const_iterator c;
     for (c = text.begin(); c != text.end(); c++)
     {
-        Character ch = m_ftCharacters[*c];
+        if ((unsigned char) *c >= m_ftCharacters.size()) continue;
+        const Character& ch = m_ftCharacters[(unsigned char) *c];
 
         float xpos = x + ch.Bearing.x * scale;
         float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
@@ -773,78 +758,129 @@ void RenderSystem::renderText(std::string text, float x, float y, float scale, c
         float w = ch.Size.x * scale;
         float h = ch.Size.y * scale;
 
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
+        vec2 top_left = trans * vec4(xpos, ypos + h, 0.f, 1.f);
+        vec2 bottom_left = trans * vec4(xpos, ypos, 0.f, 1.f);
+        vec2 bottom_right = trans * vec4(xpos + w, ypos, 0.f, 1.f);
+        vec2 top_right = trans * vec4(xpos + w, ypos + h, 0.f, 1.f);
+        const vec4& uv = ch.UVRect;
+
+        vertices.push_back({top_left, {uv.x, uv.y}, color});
+        vertices.push_back({bottom_left, {uv.x, uv.w}, color});
+        vertices.push_back({bottom_right, {uv.z, uv.w}, color});
 
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }
-        };
+        vertices.push_back({top_left, {uv.x, uv.y}, color});
+        vertices.push_back({bottom_right, {uv.z, uv.w}, color});
+        vertices.push_back({top_right, {uv.z, uv.y}, color});
 
-        // render glyph texture over quad
+        // advance to next glyph
+        x += ch.Advance * scale;
+    }
+}
+
+void RenderSystem::renderText(bnuui::Element& element) {
+    assert(text_batch_index < text_batches.size() && "more text flush points than text batches");
+
+    TextLayout& layout = text_layouts[&element];
+    if (layout.version == 0 || layout.text_revision != element.getTextRevision() ||
+        layout.position != element.position || layout.scale != element.getFontSize() ||
+        layout.color != element.color) {
+        layout.text_revision = element.getTextRevision();
+        layout.position = element.position;
+        layout.scale = element.getFontSize();
+        layout.color = element.color;
+        layout.version = ++next_text_layout_version;
+        layout.vertices.clear();
+        layoutText(element.getText(),
+                   element.position.x,
+                   WINDOW_HEIGHT_PX - element.position.y,
+                   element.getFontSize(),
+                   element.color,
+                   mat4(1.0f),
+                   layout.vertices);
+    }
+    layout.last_frame = text_frame;
 
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    TextBatch& batch = text_batches[text_batch_index];
+    batch.queued.push_back(&layout);
+    batch.queued_versions.push_back(layout.version);
+}
 
-        /*std::cout << "binding texture: " << ch.character << " = " << ch.TextureID << std::endl;*/
+void RenderSystem::flushText() {
+    assert(text_batch_index < text_batches.size() && "more text flush points than text batches");
+    TextBatch& batch = text_batches[text_batch_index++];
 
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, m_font_VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // same layouts in the same order as the last upload, the buffer already holds them
+    if (batch.queued_versions != batch.uploaded_versions) {
+        text_vertices.clear();
+        for (const TextLayout* layout : batch.queued) {
+            text_vertices.insert(text_vertices.end(), layout->vertices.begin(), layout->vertices.end());
+        }
 
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        gl_state.bindArrayBuffer(batch.vbo);
+        size_t bytes = text_vertices.size() * sizeof(TextVertex);
+        if (bytes > batch.capacity) batch.capacity = std::max(bytes, batch.capacity * 2);
+        // orphan the previous contents, growing the buffer when the text does not fit
+        glBufferData(GL_ARRAY_BUFFER, batch.capacity, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, text_vertices.data());
+        gl_has_errors();
 
-        // advance to next glyph (note that advance is number of 1/64 pixels)
-        x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
+        batch.uploaded_versions.swap(batch.queued_versions);
+        batch.uploaded_vertex_count = (GLsizei) text_vertices.size();
     }
-    glBindVertexArray(m_VAO);
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
+    batch.queued.clear();
+    batch.queued_versions.clear();
 
-void RenderSystem::drawSquareOutline(vec2 position, vec2 size, vec3 color, const mat3& projection) {
-    glUseProgram(effects[(GLuint)EFFECT_ASSET_ID::EGG]); // or a dedicated square shader
-    gl_has_errors();
+    if (batch.uploaded_vertex_count == 0) return;
 
-    // Use a simple colored quad geometry (reuse EGG or add a new one)
-    GLuint vbo = vertex_buffers[(GLuint)GEOMETRY_BUFFER_ID::HIGHLIGHT_SQUARE];
-    GLuint ibo = index_buffers[(GLuint)GEOMETRY_BUFFER_ID::HIGHLIGHT_SQUARE];
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    gl_has_errors();
+    // activate corresponding render state
+    gl_state.useProgram(pipelines[(GLuint) m_font_effect].program);
+    gl_state.bindVertexArray(batch.vao);
+    gl_state.activeTexture(GL_TEXTURE0);
+    gl_state.bindTexture2D(m_font_atlas);
 
-    GLint in_position_loc = glGetAttribLocation(effects[(GLuint)EFFECT_ASSET_ID::EGG], "in_position");
-    GLint in_color_loc = glGetAttribLocation(effects[(GLuint)EFFECT_ASSET_ID::EGG], "in_color");
-    glEnableVertexAttribArray(in_position_loc);
-    glVertexAttribPointer(in_position_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)0);
-    glEnableVertexAttribArray(in_color_loc);
-    glVertexAttribPointer(in_color_loc, 3, GL_FLOAT, GL_FALSE, sizeof(ColoredVertex), (void*)sizeof(vec3));
+    glDrawArrays(GL_TRIANGLES, 0, batch.uploaded_vertex_count);
+    frame_stats.draw_calls++;
     gl_has_errors();
+}
 
-    // Set uniforms
-    GLint color_uloc = glGetUniformLocation(effects[(GLuint)EFFECT_ASSET_ID::EGG], "fcolor");
-    glUniform3fv(color_uloc, 1, (float*)&color);
+void RenderSystem::endTextFrame() {
+    // the batches left unflushed (e.g. a scene without text) draw nothing next frame either
+    for (; text_batch_index < text_batches.size(); text_batch_index++) {
+        TextBatch& batch = text_batches[text_batch_index];
+        batch.queued.clear();
+        batch.queued_versions.clear();
+    }
+    text_batch_index = 0;
+
+    for (auto it = text_layouts.begin(); it != text_layouts.end();) {
+        if (it->second.last_frame != text_frame) {
+            it = text_layouts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    text_frame++;
+}
+
+void RenderSystem::drawSquareOutline(vec2 position, vec2 size, vec3 color, const mat3& projection) {
+    // Use a simple colored quad geometry (reuse EGG or add a new one)
+    const EffectPipeline& pipeline = usePipeline(EFFECT_ASSET_ID::EGG, GEOMETRY_BUFFER_ID::HIGHLIGHT_SQUARE);
 
     Transform transform;
     transform.translate(position);
     transform.scale(size);
 
-    GLuint transform_loc = glGetUniformLocation(effects[(GLuint)EFFECT_ASSET_ID::EGG], "transform");
-    glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*)&transform.mat);
-
-    GLuint projection_loc = glGetUniformLocation(effects[(GLuint)EFFECT_ASSET_ID::EGG], "projection");
-    glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*)&projection);
+    // Set uniforms
+    glUniform3fv(pipeline.fcolor, 1, (float*)&color);
+    glUniformMatrix3fv(pipeline.transform, 1, GL_FALSE, (float*)&transform.mat);
+    glUniformMatrix3fv(pipeline.projection, 1, GL_FALSE, (float*)&projection);
 
     // Draw
-    GLint size_bytes = 0;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size_bytes);
-    GLsizei num_indices = size_bytes / sizeof(uint16_t);
-
-    glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, nullptr);
+    glDrawElements(
+        GL_TRIANGLES, index_counts[(GLuint) GEOMETRY_BUFFER_ID::HIGHLIGHT_SQUARE], GL_UNSIGNED_SHORT, nullptr);
+    frame_stats.draw_calls++;
 }
 
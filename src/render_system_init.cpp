@@ -1,14 +1,21 @@
 // stdlib
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 
 // internal
 #include "../ext/stb_image/stb_image.h"
 #include "common.hpp"
+#include "font_atlas.hpp"
+#include "profiler.hpp"
 #include "glcorearb.h"
 #include "render_system.hpp"
+#include "texture_atlas.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
 
@@ -45,32 +52,19 @@ bool RenderSystem::particleSystemInit() {
 
     // ---- Set Up Instance Attributes ----
 
-    // Generate instance transform VBO (for a 3x3 matrix per instance).
-    glGenBuffers(1, &m_InstanceTransformVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceTransformVBO);
-    // Allocate space for instance transforms (e.g., space for 1000 instances; adjust as needed).
-    glBufferData(GL_ARRAY_BUFFER, 1000 * sizeof(mat3), nullptr, GL_DYNAMIC_DRAW);
-
-    // Setup three vertex attributes for the transform matrix at locations 2, 3, and 4.
-    // Each row of the 3x3 matrix is sent as a vec3.
-    for (int i = 0; i < 3; i++) {
-        glEnableVertexAttribArray(2 + i);
-        glVertexAttribPointer(2 + i, 3, GL_FLOAT, GL_FALSE, sizeof(mat3), (void*)(i * sizeof(vec3)));
-        // Tell OpenGL these attributes update once per instance.
-        glVertexAttribDivisor(2 + i, 1);
+    // Instances are interleaved ParticleInstance records in one ring buffer. The attribute
+    // pointers are set by drawParticles, they follow the frame's offset into the ring.
+    glGenBuffers(1, &m_particle_instance_VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_particle_instance_VBO);
+    particle_buffer_capacity = PARTICLE_BUFFER_INITIAL_CAPACITY;
+    glBufferData(GL_ARRAY_BUFFER, particle_buffer_capacity * sizeof(ParticleInstance), nullptr, GL_STREAM_DRAW);
+
+    // position, size and rotation at location 2, color at location 3, both once per instance
+    for (GLuint location = 2; location <= 3; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
     }
 
-    // Generate instance color VBO.
-    glGenBuffers(1, &m_InstanceColorVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_InstanceColorVBO);
-    // Allocate space for instance colors (vec4 per instance).
-    glBufferData(GL_ARRAY_BUFFER, 1000 * sizeof(vec4), nullptr, GL_DYNAMIC_DRAW);
-
-    // Setup the vertex attribute for color at location 5.
-    glEnableVertexAttribArray(5);
-    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(vec4), (void*)0);
-    glVertexAttribDivisor(5, 1);
-
     // Unbind the VAO (and array buffer) to avoid accidental modifications.
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -89,16 +83,67 @@ bool RenderSystem::particleSystemInit() {
     return true;
 }
 
-// Render initialization
-bool RenderSystem::init(GLFWwindow* window_arg) {
-    this->window = window_arg;
+bool RenderSystem::spriteBatchInit() {
+    assert(pipelines[(GLuint) EFFECT_ASSET_ID::SPRITE_BATCH].projection > -1);
+
+    glGenVertexArrays(1, &m_sprite_batch_VAO);
+    glGenBuffers(1, &m_sprite_instance_VBO);
+
+    // attribute locations match the layout qualifiers in sprite_batch.vs.glsl,
+    // the quad itself is the SPRITE geometry
+    glBindVertexArray(m_sprite_batch_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[(GLuint) GEOMETRY_BUFFER_ID::SPRITE]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(GLuint) GEOMETRY_BUFFER_ID::SPRITE]);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*) 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TexturedVertex), (void*) sizeof(vec3));
+    gl_has_errors();
+
+    // the instance attribute pointers are set per run, see RenderSystem::drawSpriteRun
+    for (GLuint location = 2; location <= 6; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    gl_has_errors();
+
+    growSpriteBatch(SPRITE_BATCH_INITIAL_CAPACITY);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(m_VAO);
+    return true;
+}
 
-    glfwMakeContextCurrent(window);
-    // glfwSwapInterval(1);  // vsync
+// Reallocates the instance buffer to hold at least sprite_count sprites
+void RenderSystem::growSpriteBatch(size_t sprite_count) {
+    size_t capacity = std::max(sprite_batch_capacity, SPRITE_BATCH_INITIAL_CAPACITY);
+    while (capacity < sprite_count) capacity *= 2;
+    if (capacity == sprite_batch_capacity) return;
 
-    // Load OpenGL function pointers
-    const int is_fine = gl3w_init();
-    assert(is_fine == 0);
+    gl_state.bindArrayBuffer(m_sprite_instance_VBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+    gl_has_errors();
+
+    sprite_batch_capacity = capacity;
+}
+
+// Render initialization
+bool RenderSystem::init(GLFWwindow* window_arg, RENDER_BACKEND backend_arg) {
+    this->window = window_arg;
+    this->backend = backend_arg;
+
+    if (backend == RENDER_BACKEND::WINDOW) {
+        glfwMakeContextCurrent(window);
+        // glfwSwapInterval(1);  // vsync
+
+        // Load OpenGL function pointers
+        const int is_fine = gl3w_init();
+        assert(is_fine == 0);
+    } else if (backend == RENDER_BACKEND::HEADLESS) {
+        if (!createHeadlessContext()) return false;
+    } else {
+        installNullGL();
+    }
 
     // Create a frame buffer
     frame_buffer = 0;
@@ -108,11 +153,9 @@ bool RenderSystem::init(GLFWwindow* window_arg) {
 
     // For some high DPI displays (ex. Retina Display on Macbooks)
     // https://stackoverflow.com/questions/36672935/why-retina-screen-coordinate-value-is-twice-the-value-of-pixel-value
-    int frame_buffer_width_px, frame_buffer_height_px;
-    glfwGetFramebufferSize(
-        window,
-        &frame_buffer_width_px,
-        &frame_buffer_height_px);  // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+    ivec2 frame_buffer_size = getFramebufferSize();
+    int frame_buffer_width_px = frame_buffer_size.x;
+    int frame_buffer_height_px = frame_buffer_size.y;
     if (frame_buffer_width_px != WINDOW_WIDTH_PX) {
         printf(
             "WARNING: retina display! "
@@ -150,22 +193,23 @@ bool RenderSystem::init(GLFWwindow* window_arg) {
     //}
 
     particleSystemInit();
+    spriteBatchInit();
+    gpu_timer.init();
     return true;
 }
 
 
 bool RenderSystem::fontInit(const std::string& font_filename, unsigned int font_default_size) {
+    PROFILE_ZONE("render.font_init");
     // read in our shader files
     // enable blending or you will just get solid boxes instead of text
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // font buffer setup
-    glGenVertexArrays(1, &m_font_VAO);
-    glGenBuffers(1, &m_font_VBO);
-
-    const GLuint font_effect_enum = (GLuint) EFFECT_ASSET_ID::FONT;
-    m_font_shaderProgram = (GLuint) effects[font_effect_enum];
+    // the distance field atlas is baked once, any font size scales it with the FONT_SDF shader
+    bool use_sdf = FONT_SDF_SPREAD > 0;
+    m_font_effect = use_sdf ? EFFECT_ASSET_ID::FONT_SDF : EFFECT_ASSET_ID::FONT;
+    m_font_shaderProgram = (GLuint) effects[(GLuint) m_font_effect];
 
     // apply projection matrix for font
     glUseProgram(m_font_shaderProgram);
@@ -175,85 +219,58 @@ bool RenderSystem::fontInit(const std::string& font_filename, unsigned int font_
     std::cout << "project_location: " << project_location << std::endl;
     glUniformMatrix4fv(project_location, 1, GL_FALSE, glm::value_ptr(projection));
 
-    // init FreeType fonts
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft))
-    {
-        std::cerr << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return false;
+    auto start = std::chrono::high_resolution_clock::now();
+    FontAtlas atlas;
+    int bake_size = use_sdf ? FONT_SDF_BAKE_SIZE : (int) font_default_size;
+    std::string cache_filename = font_filename + ".sdfcache";
+    bool cached = use_sdf && loadFontAtlasCache(cache_filename, font_filename, bake_size, FONT_SDF_SPREAD, atlas);
+    if (!cached) {
+        if (!bakeFontAtlas(font_filename, bake_size, FONT_SDF_SPREAD, atlas)) return false;
+        if (use_sdf) saveFontAtlasCache(cache_filename, font_filename, atlas);
     }
-
-    FT_Face face;
-    if (FT_New_Face(ft, font_filename.c_str(), 0, &face))
-    {
-        std::cerr << "ERROR::FREETYPE: Failed to load font: " << font_filename << std::endl;
-        return false;
+    float load_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Font atlas " << atlas.size << "x" << atlas.size << (cached ? " loaded from cache" : " baked")
+              << " in " << load_ms << " ms" << std::endl;
+
+    // metrics are kept in pixels of the default size, renderText scales them by the font size
+    float metric_scale = (float) font_default_size / atlas.bake_size;
+    for (int c = 0; c < 128; c++) {
+        const FontGlyph& glyph = atlas.glyphs[c];
+        Character& character = m_ftCharacters[c];
+        character.UVRect = glyph.uv_rect;
+        character.Size = glyph.size * metric_scale;
+        character.Bearing = glyph.bearing * metric_scale;
+        character.Advance = glyph.advance * metric_scale;
+        character.character = (char) c;
     }
 
-    // extract a default size
-    FT_Set_Pixel_Sizes(face, 0, font_default_size);
-
     // disable byte-alignment restriction in OpenGL
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    // load each of the chars - note only first 128 ASCII chars
-    for (unsigned char c = (unsigned char)0; c < (unsigned char)128; c++)
-    {
-        // load character glyph 
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-        {
-            std::cerr << "ERROR::FREETYTPE: Failed to load Glyph " << c << std::endl;
-            continue;
-        }
-
-        // generate texture
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        // std::cout << "texture: " << c << " = " << texture << std::endl;
-
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        // set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+    glGenTextures(1, &m_font_atlas);
+    glBindTexture(GL_TEXTURE_2D, m_font_atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas.size, atlas.size, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.pixels.data());
 
-        // now store character for later use
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            static_cast<unsigned int>(face->glyph->advance.x),
-            (char)c
-        };
-        m_ftCharacters.insert(std::pair<char, Character>(c, character));
-    }
+    // set texture options, distance fields are interpolated
+    GLint filter = use_sdf ? GL_LINEAR : GL_NEAREST;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
     glBindTexture(GL_TEXTURE_2D, 0);
+    gl_has_errors();
 
-    // clean up
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-
-    // bind buffers
-    glBindVertexArray(m_font_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_font_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    // font buffer setup, one per text batch, the vertex data is uploaded by flushText
+    for (TextBatch& batch : text_batches) {
+        glGenVertexArrays(1, &batch.vao);
+        glGenBuffers(1, &batch.vbo);
+        glBindVertexArray(batch.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*) offsetof(TextVertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*) offsetof(TextVertex, color));
+    }
 
     // release buffers
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -264,6 +281,22 @@ bool RenderSystem::fontInit(const std::string& font_filename, unsigned int font_
 }
 
 void RenderSystem::initializeGlTextures() {
+    PROFILE_ZONE("render.load_textures");
+    // small sprites share atlas pages so the sprite batch can draw them in one run,
+    // backgrounds, cutscenes and full screen texts stay standalone
+    std::vector<ivec2> packed_sizes(texture_paths.size(), ivec2(0));
+    for (uint i = 0; i < texture_paths.size(); i++) {
+        ivec2 size;
+        if (!stbi_info(texture_paths[i].c_str(), &size.x, &size.y, NULL)) continue;
+        if (size.x <= TEXTURE_ATLAS_MAX_SPRITE_SIZE && size.y <= TEXTURE_ATLAS_MAX_SPRITE_SIZE) {
+            packed_sizes[i] = size;
+        }
+    }
+    std::vector<AtlasRegion> regions;
+    int page_count = packAtlasRegions(packed_sizes, TEXTURE_ATLAS_SIZE, TEXTURE_ATLAS_PADDING, regions);
+    std::vector<std::vector<uint8_t>> pages(page_count);
+    for (std::vector<uint8_t>& page : pages) page.assign(TEXTURE_ATLAS_SIZE * TEXTURE_ATLAS_SIZE * 4, 0);
+
     glGenTextures((GLsizei) texture_gl_handles.size(), texture_gl_handles.data());
 
     for (uint i = 0; i < texture_paths.size(); i++) {
@@ -278,6 +311,15 @@ void RenderSystem::initializeGlTextures() {
             fprintf(stderr, "%s", message.c_str());
             assert(false);
         }
+        // the file can have changed between stbi_info and stbi_load, keep it standalone then
+        if (regions[i].page >= 0 && regions[i].size == dimensions) {
+            copySpriteToAtlas(pages[regions[i].page], TEXTURE_ATLAS_SIZE, data, regions[i], TEXTURE_ATLAS_PADDING);
+            texture_uv_rects[i] = atlasUVRect(regions[i], TEXTURE_ATLAS_SIZE);
+            stbi_image_free(data);
+            continue;
+        }
+        regions[i].page = -1;
+        texture_uv_rects[i] = {0.f, 0.f, 1.f, 1.f};
         glBindTexture(GL_TEXTURE_2D, texture_gl_handles[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dimensions.x, dimensions.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -285,19 +327,94 @@ void RenderSystem::initializeGlTextures() {
         gl_has_errors();
         stbi_image_free(data);
     }
+
+    texture_atlas_pages.resize(page_count);
+    glGenTextures((GLsizei) page_count, texture_atlas_pages.data());
+    for (int p = 0; p < page_count; p++) {
+        glBindTexture(GL_TEXTURE_2D, texture_atlas_pages[p]);
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_RGBA,
+                     TEXTURE_ATLAS_SIZE,
+                     TEXTURE_ATLAS_SIZE,
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     pages[p].data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl_has_errors();
+    }
+
+    // packed assets point at their page, the names generated for them are not needed
+    for (uint i = 0; i < texture_paths.size(); i++) {
+        if (regions[i].page < 0) continue;
+        glDeleteTextures(1, &texture_gl_handles[i]);
+        texture_gl_handles[i] = texture_atlas_pages[regions[i].page];
+    }
     gl_has_errors();
 }
 
 void RenderSystem::initializeGlEffects() {
+    PROFILE_ZONE("render.load_shaders");
     for (uint i = 0; i < effect_paths.size(); i++) {
         const std::string vertex_shader_name = effect_paths[i] + ".vs.glsl";
         const std::string fragment_shader_name = effect_paths[i] + ".fs.glsl";
 
         bool is_valid = loadEffectFromFile(vertex_shader_name, fragment_shader_name, effects[i]);
         assert(is_valid && (GLuint) effects[i] != 0);
+
+        // cache every location the draw functions use, unused names stay -1
+        EffectPipeline& pipeline = pipelines[i];
+        pipeline.program = effects[i];
+        pipeline.in_position = glGetAttribLocation(effects[i], "in_position");
+        pipeline.in_texcoord = glGetAttribLocation(effects[i], "in_texcoord");
+        pipeline.in_color = glGetAttribLocation(effects[i], "in_color");
+        pipeline.transform = glGetUniformLocation(effects[i], "transform");
+        pipeline.projection = glGetUniformLocation(effects[i], "projection");
+        pipeline.fcolor = glGetUniformLocation(effects[i], "fcolor");
+        pipeline.uv_rect = glGetUniformLocation(effects[i], "uv_rect");
+        pipeline.alpha = glGetUniformLocation(effects[i], "alpha");
+        pipeline.visible = glGetUniformLocation(effects[i], "visible");
+        pipeline.num_centers = glGetUniformLocation(effects[i], "num_centers");
+        pipeline.centers = glGetUniformLocation(effects[i], "centers");
+        pipeline.time = glGetUniformLocation(effects[i], "time");
+        pipeline.darken_screen_factor = glGetUniformLocation(effects[i], "darken_screen_factor");
+        gl_has_errors();
     }
 }
 
+// Both vertex types keep the position first and their second attribute right after it,
+// so the layout only depends on the stride of the geometry and the inputs of the effect
+GLuint RenderSystem::geometryVAO(EFFECT_ASSET_ID effect, GEOMETRY_BUFFER_ID geometry) {
+    GLuint& vao = geometry_vaos[(GLuint) effect * geometry_count + (GLuint) geometry];
+    if (vao != 0) return vao;
+
+    const EffectPipeline& pipeline = pipelines[(GLuint) effect];
+    const GLsizei stride = vertex_strides[(GLuint) geometry];
+    assert(stride > 0 && "geometry has no vertex buffer");
+
+    glGenVertexArrays(1, &vao);
+    gl_state.bindVertexArray(vao);
+    gl_state.bindArrayBuffer(vertex_buffers[(GLuint) geometry]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(GLuint) geometry]);
+
+    if (pipeline.in_position >= 0) {
+        glEnableVertexAttribArray(pipeline.in_position);
+        glVertexAttribPointer(pipeline.in_position, 3, GL_FLOAT, GL_FALSE, stride, (void*) 0);
+    }
+    if (pipeline.in_texcoord >= 0) {
+        glEnableVertexAttribArray(pipeline.in_texcoord);
+        glVertexAttribPointer(pipeline.in_texcoord, 2, GL_FLOAT, GL_FALSE, stride, (void*) sizeof(vec3));
+    }
+    if (pipeline.in_color >= 0) {
+        glEnableVertexAttribArray(pipeline.in_color);
+        glVertexAttribPointer(pipeline.in_color, 3, GL_FLOAT, GL_FALSE, stride, (void*) sizeof(vec3));
+    }
+    gl_has_errors();
+    return vao;
+}
+
 // One could merge the following two functions as a template function...
 template <class T>
 void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices, std::vector<uint16_t> indices) {
@@ -308,6 +425,9 @@ void RenderSystem::bindVBOandIBO(GEOMETRY_BUFFER_ID gid, std::vector<T> vertices
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers[(uint) gid]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * indices.size(), indices.data(), GL_STATIC_DRAW);
     gl_has_errors();
+
+    index_counts[(uint) gid] = (GLsizei) indices.size();
+    vertex_strides[(uint) gid] = (GLsizei) sizeof(T);
 }
 
 void RenderSystem::initializeGlMeshes() {
@@ -555,11 +675,25 @@ void RenderSystem::initializeGlGeometryBuffers() {
 RenderSystem::~RenderSystem() {
     // Don't need to free gl resources since they last for as long as the program,
     // but it's polite to clean after yourself.
+    gpu_timer.destroy();
     glDeleteBuffers((GLsizei) vertex_buffers.size(), vertex_buffers.data());
     glDeleteBuffers((GLsizei) index_buffers.size(), index_buffers.data());
+    glDeleteTextures(1, &m_font_atlas);
+    for (TextBatch& batch : text_batches) {
+        glDeleteBuffers(1, &batch.vbo);
+        glDeleteVertexArrays(1, &batch.vao);
+    }
+    // atlas pages appear in texture_gl_handles as well, deleting a name twice is ignored
     glDeleteTextures((GLsizei) texture_gl_handles.size(), texture_gl_handles.data());
+    glDeleteTextures((GLsizei) texture_atlas_pages.size(), texture_atlas_pages.data());
     glDeleteTextures(1, &off_screen_render_buffer_color);
     glDeleteRenderbuffers(1, &off_screen_render_buffer_depth);
+    glDeleteBuffers(1, &m_sprite_instance_VBO);
+    glDeleteBuffers(1, &m_particle_instance_VBO);
+    glDeleteVertexArrays(1, &m_sprite_batch_VAO);
+    for (GLuint vao : geometry_vaos) {
+        if (vao != 0) glDeleteVertexArrays(1, &vao);
+    }
     gl_has_errors();
 
     for (uint i = 0; i < effect_count; i++) {
@@ -567,7 +701,12 @@ RenderSystem::~RenderSystem() {
     }
     // delete allocated resources
     glDeleteFramebuffers(1, &frame_buffer);
+    if (screen_frame_buffer != 0) {
+        glDeleteFramebuffers(1, &screen_frame_buffer);
+        glDeleteRenderbuffers(1, &screen_render_buffer_color);
+    }
     gl_has_errors();
+    if (backend == RENDER_BACKEND::HEADLESS) destroyHeadlessContext();
 
     // remove all entities created by the render system
     while (registry.renderRequests.entities.size() > 0)
@@ -579,11 +718,9 @@ bool RenderSystem::initScreenTexture() {
     // create a single entry
     registry.screenStates.emplace(screen_state_entity);
 
-    int framebuffer_width, framebuffer_height;
-    glfwGetFramebufferSize(
-        const_cast<GLFWwindow*>(window),
-        &framebuffer_width,
-        &framebuffer_height);  // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+    ivec2 framebuffer_size = getFramebufferSize();
+    int framebuffer_width = framebuffer_size.x;
+    int framebuffer_height = framebuffer_size.y;
 
     glGenTextures(1, &off_screen_render_buffer_color);
     glBindTexture(GL_TEXTURE_2D, off_screen_render_buffer_color);
@@ -601,9 +738,32 @@ bool RenderSystem::initScreenTexture() {
 
     assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
 
+    // without a window drawToScreen presents into an RGBA8 target that frame dumps read back
+    if (backend != RENDER_BACKEND::WINDOW) {
+        glGenFramebuffers(1, &screen_frame_buffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, screen_frame_buffer);
+        glGenRenderbuffers(1, &screen_render_buffer_color);
+        glBindRenderbuffer(GL_RENDERBUFFER, screen_render_buffer_color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, framebuffer_width, framebuffer_height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, screen_render_buffer_color);
+        gl_has_errors();
+
+        assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+    }
+
     return true;
 }
 
+ivec2 RenderSystem::getFramebufferSize() const {
+    if (window == nullptr) return ivec2(WINDOW_WIDTH_PX, WINDOW_HEIGHT_PX);
+
+    // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
+    ivec2 size;
+    glfwGetFramebufferSize(const_cast<GLFWwindow*>(window), &size.x, &size.y);
+    return size;
+}
+
 bool gl_compile_shader(GLuint shader) {
     glCompileShader(shader);
     gl_has_errors();
@@ -0,0 +1,20 @@
+#include "rng.hpp"
+
+// stlib
+#include <random>
+
+RngService& RngService::getInstance() {
+    static RngService instance;
+    return instance;
+}
+
+RngService::RngService() {
+    seed(std::random_device()());
+}
+
+void RngService::seed(uint32_t seed_value) {
+    session_seed = seed_value;
+    for (int i = 0; i < rng_stream_count; i++) {
+        streams[i].seed(seed_value, (uint64_t) i);
+    }
+}
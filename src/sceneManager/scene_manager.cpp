@@ -1,6 +1,8 @@
 #include "sceneManager/scene_manager.hpp"
 #include "sceneManager/scene.hpp"
 
+#include "profiler.hpp"
+
 void SceneManager::registerScene(Scene* scene) {
     scenes[scene->getName()] = scene;
 }
@@ -35,6 +37,7 @@ std::string SceneManager::getNewLevelSceneName(){
 // If we do, then we will switch the scene, otherwise do nothing.
 void SceneManager::checkSceneSwitch() {
     if (nextScene != nullptr) {
+        PROFILE_ZONE("scene.switch");
         if (currScene) {
             currScene->Exit();
         }
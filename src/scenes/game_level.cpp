@@ -13,6 +13,7 @@
 #include "bnuui/bnuui.hpp"
 #include "camera_system.hpp"
 #include "common.hpp"
+#include "contact_cache.hpp"
 #include "gacha_system.hpp"
 #include "inventory_system.hpp"
 #include "tinyECS/components.hpp"
@@ -532,6 +533,7 @@ void GameLevel::Exit() {
     cs->position = {0.0f, 0.0f};
     cs->prev_pos = {0.0f, 0.0f};
     cs->vel = {0.0f, 0.0f};
+    ContactCache::getInstance().clear();
     // Delete all components and stuff from this scene.
 
     while (registry.cameras.entities.size() > 0){
@@ -1248,7 +1250,7 @@ void GameLevel::UpdateDropoffProgressBar() {
     float base_width = base_motion.scale.x, base_height = base_motion.scale.y;
     float base_perimeter = 2 * (base_width + base_height);
 
-    std::vector<tson::Vector2i> original_corners = get_poly_from_motion(base_motion);
+    std::array<tson::Vector2i, 4> original_corners = get_corners_from_motion(base_motion);
 
     GridLine& lineUL = registry.gridLines.get(base_corners[0]);
     GridLine& lineUR = registry.gridLines.get(base_corners[1]);
@@ -1308,20 +1310,45 @@ void GameLevel::RemoveStation(vec2 tile_pos, MODULE_TYPES module){
 
 
 void GameLevel::Update(float dt) {
+    system_timings.updates++;
     if(!RenderSystem::isRenderingGacha && 
         registry.players.components[0].player_state != BUILDING && 
         !RenderSystem::isRenderingBook &&
         !RenderSystem::isPaused){
-        CameraSystem::GetInstance()->update(dt);
-        ai_system.step(dt);
-        physics_system.step(dt);
-        animation_system.step(dt);
-        module_system.step(dt);
-        particle_system.step(dt);
-        HandleCameraMovement();
-
-        world_system->handle_collisions();
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::CAMERA);
+            CameraSystem::GetInstance()->update(dt);
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::AI);
+            ai_system.step(dt);
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::PHYSICS);
+            physics_system.step(dt);
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::ANIMATION);
+            animation_system.step(dt);
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::MODULES);
+            module_system.step(dt);
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::PARTICLES);
+            particle_system.step(dt);
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::CAMERA);
+            HandleCameraMovement();
+        }
+        {
+            ScopedSystemTimer timer(system_timings, SIM_SYSTEM::COLLISIONS);
+            world_system->handle_collisions();
+        }
 
+        ScopedSystemTimer timer(system_timings, SIM_SYSTEM::LIFETIMES);
         // Remove projectiles.
         for (Entity e : registry.playerProjectiles.entities) {
             if (registry.playerProjectiles.has(e)) {
@@ -1378,9 +1405,12 @@ void GameLevel::Update(float dt) {
         }
     }
 
-    UpdateDropoffProgressBar();
-
+    {
+        ScopedSystemTimer timer(system_timings, SIM_SYSTEM::LEVEL);
+        UpdateDropoffProgressBar();
+        LevelUpdate(dt);
+    }
 
-    LevelUpdate(dt);
+    ScopedSystemTimer timer(system_timings, SIM_SYSTEM::UI);
     scene_ui.update(dt);
 }
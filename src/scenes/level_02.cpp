@@ -38,8 +38,7 @@ void Level02::LevelHandleMouseClick(int button, int action, int mods) {}
 void Level02::LevelUpdate(float dt) {
     // update window title with points
     int points = registry.base.components[0].bunny_count;
-    std::string title_points = std::to_string(points);
-    world_system->add_to_title("Total bunny saved: " + title_points + "/" + std::to_string(bunnies_to_win));
+    world_system->set_title_progress(points, bunnies_to_win);
     if (registry.base.components[0].bunny_count == bunnies_to_win) {
         std::cout << "BEAT LEVEL -- SAVED ALL [" << bunnies_to_win << "] BUNNIES" << std::endl; 
     }
@@ -0,0 +1,70 @@
+#include "texture_atlas.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+int packAtlasRegions(const std::vector<ivec2>& sizes, int page_size, int padding, std::vector<AtlasRegion>& regions) {
+    regions.assign(sizes.size(), AtlasRegion());
+
+    std::vector<size_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a].y > sizes[b].y; });
+
+    int page = 0;
+    int shelf_x = 0;
+    int shelf_y = 0;
+    int shelf_height = 0;
+    bool page_used = false;
+    for (size_t i : order) {
+        // empty entries need no texels, they keep page -1
+        if (sizes[i].x <= 0 || sizes[i].y <= 0) continue;
+        ivec2 padded = sizes[i] + 2 * padding;
+        if (padded.x > page_size || padded.y > page_size) continue;
+
+        if (shelf_x + padded.x > page_size) {
+            shelf_y += shelf_height;
+            shelf_x = 0;
+            shelf_height = 0;
+        }
+        if (shelf_y + padded.y > page_size) {
+            page++;
+            shelf_x = 0;
+            shelf_y = 0;
+            shelf_height = 0;
+        }
+
+        regions[i].page = page;
+        regions[i].position = {shelf_x + padding, shelf_y + padding};
+        regions[i].size = sizes[i];
+        page_used = true;
+
+        shelf_x += padded.x;
+        shelf_height = std::max(shelf_height, padded.y);
+    }
+    return page_used ? page + 1 : 0;
+}
+
+void copySpriteToAtlas(std::vector<uint8_t>& page,
+                       int page_size,
+                       const uint8_t* pixels,
+                       const AtlasRegion& region,
+                       int padding) {
+    const int texel_size = 4;
+    for (int y = -padding; y < region.size.y + padding; y++) {
+        int src_y = std::min(std::max(y, 0), region.size.y - 1);
+        for (int x = -padding; x < region.size.x + padding; x++) {
+            int src_x = std::min(std::max(x, 0), region.size.x - 1);
+            const uint8_t* src = pixels + (src_y * region.size.x + src_x) * texel_size;
+            uint8_t* dst = page.data() + ((region.position.y + y) * page_size + region.position.x + x) * texel_size;
+            std::memcpy(dst, src, texel_size);
+        }
+    }
+}
+
+vec4 atlasUVRect(const AtlasRegion& region, int page_size) {
+    vec2 min = vec2(region.position) / (float) page_size;
+    vec2 max = vec2(region.position + region.size) / (float) page_size;
+    return {min.x, min.y, max.x, max.y};
+}
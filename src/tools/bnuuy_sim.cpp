@@ -0,0 +1,359 @@
+// Headless simulation runner: steps one level with a fixed dt as fast as it can, no window, audio or GL.
+//
+//   bnuuy_sim [--level=m3_level2.json] [--ticks=N] [--dt=ms] [--seed=S] [--input=script.txt]
+//             [--record=log.brec] [--replay=log.brec] [--trace=trace.json] [--stats=stats.csv]
+//             [--alloc-budget=N]
+//
+// --record writes the ticks as an input log (see input_recording.hpp). --replay takes the input, dt and
+// seed from such a log instead and stops when it runs out; --level must name the level it was recorded in.
+// --trace writes the profile zones of the load and every tick as a Chrome trace (see profiler.hpp).
+// --stats writes the per-tick frame statistics of the last FRAME_STATS_HISTORY ticks (see frame_stats.hpp).
+// --alloc-budget fails the run when a steady-state combat tick makes more than N heap allocations. Steady
+// state starts ALLOC_BUDGET_WARMUP_TICKS into the level, and a tick is combat while any enemy is alive.
+//
+// The input script has one event per line, applied before the update of its tick ('#' starts a comment):
+//   <tick> key <key> <action> <mods>       GLFW key codes, e.g. "120 key 87 1 0" presses W
+//   <tick> move <x> <y>                    cursor position in window pixels
+//   <tick> click <button> <action> <mods>
+
+// stdlib
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// internal
+#include "camera_system.hpp"
+#include "common.hpp"
+#include "frame_arena.hpp"
+#include "frame_stats.hpp"
+#include "profiler.hpp"
+#include "rng.hpp"
+#include "sceneManager/scene_manager.hpp"
+#include "scenes/game_level.hpp"
+#include "scenes/level_01.hpp"
+#include "scenes/level_02.hpp"
+#include "scenes/level_03.hpp"
+#include "scenes/level_04.hpp"
+#include "scenes/tutorial.hpp"
+#include "tinyECS/registry.hpp"
+#include "world_system.hpp"
+// the renderer is linked in for its flags, so it needs the loader even though nothing calls GL
+#define GL3W_IMPLEMENTATION
+#include <gl3w.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace {
+
+struct SimOptions {
+    std::string level = "m3_level2.json";
+    int ticks = 0;  // 10000, or the whole log when replaying
+    float dt_ms = 1000.f / 60.f;
+    unsigned int seed = 1;
+    std::string input_path;
+    std::string record_path;
+    std::string replay_path;
+    std::string trace_path;
+    std::string stats_path;
+    int alloc_budget = -1;  // allocations per tick, -1 leaves them unchecked
+};
+
+enum class SIM_INPUT { KEY, MOVE, CLICK };
+
+struct SimInputEvent {
+    int tick;
+    SIM_INPUT type;
+    int a, b, c;  // key, action, mods / x, y / button, action, mods
+};
+
+// The same map and background pairs main() registers
+GameLevel* createLevel(WorldSystem* world_system, const std::string& level) {
+    if (level == "m4_tutorial.json")
+        return new TutorialLevel(world_system, level, TEXTURE_ASSET_ID::TUTORIAL_BACKGROUND);
+    if (level == "m3_level1.json") return new Level01(world_system, level, TEXTURE_ASSET_ID::LEVEL01_BACKGROUND);
+    if (level == "m3_level2.json") return new Level02(world_system, level, TEXTURE_ASSET_ID::LEVEL02_BACKGROUND);
+    if (level == "m3_level3.json") return new Level03(world_system, level, TEXTURE_ASSET_ID::LEVEL03_BACKGROUND);
+    if (level == "m3_level4.json") return new Level04(world_system, level, TEXTURE_ASSET_ID::LEVEL04_BACKGROUND);
+    return nullptr;
+}
+
+bool parseOptions(int argc, char* argv[], SimOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strncmp(arg, "--level=", 8) == 0) {
+            options.level = arg + 8;
+        } else if (std::strncmp(arg, "--ticks=", 8) == 0) {
+            options.ticks = std::atoi(arg + 8);
+        } else if (std::strncmp(arg, "--dt=", 5) == 0) {
+            options.dt_ms = (float) std::atof(arg + 5);
+        } else if (std::strncmp(arg, "--seed=", 7) == 0) {
+            options.seed = (unsigned int) std::strtoul(arg + 7, nullptr, 10);
+        } else if (std::strncmp(arg, "--input=", 8) == 0) {
+            options.input_path = arg + 8;
+        } else if (std::strncmp(arg, "--record=", 9) == 0) {
+            options.record_path = arg + 9;
+        } else if (std::strncmp(arg, "--replay=", 9) == 0) {
+            options.replay_path = arg + 9;
+        } else if (std::strncmp(arg, "--trace=", 8) == 0) {
+            options.trace_path = arg + 8;
+        } else if (std::strncmp(arg, "--stats=", 8) == 0) {
+            options.stats_path = arg + 8;
+        } else if (std::strncmp(arg, "--alloc-budget=", 15) == 0) {
+            options.alloc_budget = std::atoi(arg + 15);
+        } else {
+            std::cerr << "ERROR: Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.ticks >= 0 && options.dt_ms > 0.f;
+}
+
+bool loadInputScript(const std::string& path, std::vector<SimInputEvent>& events) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "ERROR: Could not open input script " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        SimInputEvent event = {};
+        std::string type;
+        if (!(stream >> event.tick)) continue;  // blank or comment only
+
+        bool ok = (bool) (stream >> type);
+        if (ok && type == "key") {
+            event.type = SIM_INPUT::KEY;
+            ok = (bool) (stream >> event.a >> event.b >> event.c);
+        } else if (ok && type == "move") {
+            event.type = SIM_INPUT::MOVE;
+            ok = (bool) (stream >> event.a >> event.b);
+        } else if (ok && type == "click") {
+            event.type = SIM_INPUT::CLICK;
+            ok = (bool) (stream >> event.a >> event.b >> event.c);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "ERROR: " << path << ":" << line_number << ": bad input event" << std::endl;
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const SimInputEvent& a, const SimInputEvent& b) {
+        return a.tick < b.tick;
+    });
+    return true;
+}
+
+// FNV-1a over every motion, two runs with the same seed and input must end on the same hash
+uint32_t motionHash() {
+    uint32_t hash = 2166136261u;
+    for (const Motion& motion : registry.motions.components) {
+        const float values[] = {motion.position.x, motion.position.y, motion.velocity.x, motion.velocity.y};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values);
+        for (size_t i = 0; i < sizeof(values); i++) hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void applyInput(WorldSystem& world_system, const SimInputEvent& event) {
+    switch (event.type) {
+        case SIM_INPUT::KEY:
+            world_system.on_key(event.a, 0, event.b, event.c);
+            break;
+        case SIM_INPUT::MOVE:
+            world_system.on_mouse_move(vec2(event.a, event.b));
+            break;
+        case SIM_INPUT::CLICK:
+            world_system.on_mouse_button_pressed(event.a, event.b, event.c);
+            break;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: bnuuy_sim [--level=m3_level2.json] [--ticks=N] [--dt=ms] [--seed=S] [--input=script.txt]"
+                     " [--record=log.brec] [--replay=log.brec] [--trace=trace.json]"
+                     " [--stats=stats.csv] [--alloc-budget=N]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<SimInputEvent> events;
+    if (!options.input_path.empty() && !loadInputScript(options.input_path, events)) return EXIT_FAILURE;
+
+    InputReplay replay;
+    bool replaying = !options.replay_path.empty();
+    if (replaying) {
+        if (!replay.open(options.replay_path)) return EXIT_FAILURE;
+        options.seed = replay.getSeed();
+    }
+    if (options.ticks == 0) options.ticks = replaying ? INT_MAX : 10000;
+    RngService::getInstance().seed(options.seed);
+    Profiler::nameThread("main");
+    if (!options.trace_path.empty()) Profiler::start();
+
+    // no window and no renderer, the world only needs the renderer for drawing
+    WorldSystem world_system;
+    world_system.init(nullptr);
+
+    InputRecorder recorder;
+    if (!options.record_path.empty()) {
+        if (!recorder.open(options.record_path, options.seed)) return EXIT_FAILURE;
+        world_system.setInputRecorder(&recorder);
+    }
+
+    GameLevel* level = createLevel(&world_system, options.level);
+    if (level == nullptr) {
+        std::cerr << "ERROR: Unknown level " << options.level << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // only the level is registered, requests to switch to any other scene are ignored
+    SceneManager& scene_manager = SceneManager::getInstance();
+    scene_manager.registerScene(level);
+    scene_manager.switchScene(level->getName());
+
+    auto load_start = Clock::now();
+    scene_manager.checkSceneSwitch();
+    float load_ms =
+        (float) (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - load_start)).count() / 1000;
+    level->getSystemTimings()->reset();
+
+    size_t next_event = 0;
+    int tick = 0;
+    int over_budget_ticks = 0;
+    FrameSample worst_tick;  // the combat tick with the most allocations
+    bool checked_combat = false;
+    double simulated_ms = 0.0;
+    auto run_start = Clock::now();
+    for (; tick < options.ticks; tick++) {
+        PROFILE_ZONE("tick");
+        float dt_ms = options.dt_ms;
+        if (replaying) {
+            if (!replay.nextTick(world_system, dt_ms)) break;
+        } else {
+            while (next_event < events.size() && events[next_event].tick <= tick) {
+                applyInput(world_system, events[next_event++]);
+            }
+        }
+        recorder.endTick(dt_ms);
+
+        // the timings add up over the run for the table, the statistics get each tick's share
+        SystemTimings before_tick = *level->getSystemTimings();
+        auto tick_start = Clock::now();
+        scene_manager.checkSceneSwitch();
+        Scene* scene = scene_manager.getCurrentScene();
+        if (scene != nullptr) scene->Update(dt_ms);
+        simulated_ms += dt_ms;
+
+        FrameSample sample;
+        sample.update_ms =
+            (float) (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tick_start)).count() / 1000;
+        sample.frame_ms = sample.update_ms;
+        for (int i = 0; i < sim_system_count; i++) {
+            sample.system_ms[i] = (float) (level->getSystemTimings()->ms[i] - before_tick.ms[i]);
+        }
+        FrameStats::getInstance().endFrame(sample);
+
+        if (options.alloc_budget >= 0 && tick >= ALLOC_BUDGET_WARMUP_TICKS && registry.enemies.size() > 0) {
+            const FrameSample& latest = FrameStats::getInstance().frame(0);
+            if (!checked_combat || latest.allocations > worst_tick.allocations) worst_tick = latest;
+            checked_combat = true;
+            if (latest.allocations > (uint32_t) options.alloc_budget) over_budget_ticks++;
+        }
+
+        // nothing plays them, so drop the sounds the tick requested
+        while (registry.sounds.entities.size() > 0) registry.remove_all_components_of(registry.sounds.entities.back());
+        FrameArena::endFrame();
+    }
+    double run_ms =
+        (double) (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - run_start)).count() / 1000;
+
+    const SystemTimings& timings = *level->getSystemTimings();
+    printf("\nlevel %s, seed %u, %d ticks, %.1f s simulated (load %.1f ms)\n",
+           options.level.c_str(),
+           options.seed,
+           tick,
+           simulated_ms / 1000.0,
+           load_ms);
+    printf("%.1f ms wall, %.0f ticks/sec, %.1fx real time\n",
+           run_ms,
+           tick / (run_ms / 1000.0),
+           simulated_ms / run_ms);
+    FrameTimeSummary tick_summary = FrameStats::getInstance().summarize(&FrameSample::update_ms);
+    printf("last %zu ticks: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           FrameStats::getInstance().size(),
+           tick_summary.p50,
+           tick_summary.p95,
+           tick_summary.p99,
+           tick_summary.max);
+    // the window only holds the last FRAME_STATS_HISTORY ticks, so allocations are averaged over it
+    std::array<double, sim_system_count> system_allocations = {};
+    std::array<double, sim_system_count> system_bytes = {};
+    size_t window = FrameStats::getInstance().size();
+    for (size_t age = 0; age < window; age++) {
+        const FrameSample& sample = FrameStats::getInstance().frame(age);
+        for (int i = 0; i < sim_system_count; i++) {
+            system_allocations[i] += (double) sample.system_allocations[i] / window;
+            system_bytes[i] += (double) sample.system_allocated_bytes[i] / window;
+        }
+    }
+    printf("%-12s %10s %10s %7s %12s %12s\n", "system", "total ms", "us/tick", "share", "allocs/tick", "bytes/tick");
+    double systems_ms = 0.0;
+    for (double ms : timings.ms) systems_ms += ms;
+    for (int i = 0; i < sim_system_count; i++) {
+        printf("%-12s %10.2f %10.2f %6.1f%% %12.1f %12.0f\n",
+               sim_system_names[i],
+               timings.ms[i],
+               tick > 0 ? timings.ms[i] * 1000.0 / tick : 0.0,
+               systems_ms > 0.0 ? 100.0 * timings.ms[i] / systems_ms : 0.0,
+               system_allocations[i],
+               system_bytes[i]);
+    }
+    printf("entities with motion at exit: %zu, state hash %08x\n", registry.motions.entities.size(), motionHash());
+    recorder.close();
+    if (!options.trace_path.empty()) Profiler::writeChromeTrace(options.trace_path);
+    if (!options.stats_path.empty()) FrameStats::getInstance().exportFile(options.stats_path);
+
+    bool within_budget = true;
+    if (options.alloc_budget >= 0) {
+        if (!checked_combat) {
+            printf("alloc budget: no combat ticks after the %d tick warm-up, nothing checked\n",
+                   ALLOC_BUDGET_WARMUP_TICKS);
+        } else {
+            within_budget = over_budget_ticks == 0;
+            printf("alloc budget %d per tick: %s, %d combat ticks over, worst was tick %llu with %u (%llu bytes)\n",
+                   options.alloc_budget,
+                   within_budget ? "PASS" : "FAIL",
+                   over_budget_ticks,
+                   (unsigned long long) worst_tick.frame,
+                   worst_tick.allocations,
+                   (unsigned long long) worst_tick.allocated_bytes);
+            for (int i = 0; i < sim_system_count; i++) {
+                if (worst_tick.system_allocations[i] == 0) continue;
+                printf("  %-12s %u allocations, %llu bytes\n",
+                       sim_system_names[i],
+                       worst_tick.system_allocations[i],
+                       (unsigned long long) worst_tick.system_allocated_bytes[i]);
+            }
+        }
+    }
+
+    delete level;
+    delete (CameraSystem::GetInstance());
+    return within_budget ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,78 @@
+// Times the motion integration: the in-place AoS loop the physics step runs against integrateSoA.
+//
+//   motion_bench [--steps=N]
+//
+// For 1k, 10k and 100k bodies prints the time per step of integrateMotions, of integrateSoA on data that is
+// already SoA (as the particle pools are), and of copying the motions into SoA arrays, running the kernel
+// and copying the positions back. The copies are why registry.motions is integrated in place.
+
+// stdlib
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// internal
+#include "motion_integration.hpp"
+
+namespace {
+template <typename Step>
+float microsecondsPerStep(int steps, Step step) {
+    using clock = std::chrono::high_resolution_clock;
+    step();  // warm the caches
+    auto start = clock::now();
+    for (int i = 0; i < steps; i++) step();
+    return std::chrono::duration<float, std::micro>(clock::now() - start).count() / steps;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int steps = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--steps=", 8) == 0) {
+            steps = atoi(argv[i] + 8);
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const float step_seconds = 1.f / 60.f;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> value(-100.f, 100.f);
+
+    printf("%-8s %12s %12s %24s\n", "bodies", "AoS loop", "SoA kernel", "gather+kernel+scatter");
+    for (size_t body_count : {1000, 10000, 100000}) {
+        ComponentContainer<Motion> motions;
+        motions.components.resize(body_count);
+        for (Motion& motion : motions.components) {
+            motion.position = {value(rng), value(rng)};
+            motion.velocity = {value(rng), value(rng)};
+        }
+        std::vector<float> x(body_count), y(body_count), vx(body_count), vy(body_count);
+        auto gather = [&]() {
+            for (size_t i = 0; i < body_count; i++) {
+                const Motion& motion = motions.components[i];
+                x[i] = motion.position.x;
+                y[i] = motion.position.y;
+                vx[i] = motion.velocity.x;
+                vy[i] = motion.velocity.y;
+            }
+        };
+        gather();
+
+        float aos_us = microsecondsPerStep(steps, [&]() { integrateMotions(motions, step_seconds); });
+        float kernel_us = microsecondsPerStep(steps, [&]() {
+            integrateSoA(x.data(), y.data(), vx.data(), vy.data(), body_count, step_seconds);
+        });
+        float soa_us = microsecondsPerStep(steps, [&]() {
+            gather();
+            integrateSoA(x.data(), y.data(), vx.data(), vy.data(), body_count, step_seconds);
+            for (size_t i = 0; i < body_count; i++) motions.components[i].position = {x[i], y[i]};
+        });
+        printf("%-8zu %10.2fus %10.2fus %22.2fus\n", body_count, aos_us, kernel_us, soa_us);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+// Checks the narrowphase lane kernels against a plain scalar reference and times both.
+//
+//   narrowphase_check [--pairs=N] [--seed=S]
+//
+// Fills N random circle and box pairs (100000 by default), runs narrowphaseCircles / narrowphaseBoxes and
+// the reference over them, and fails when the hit lists differ. A third of the pairs are placed right on
+// the touching distance so the comparisons at the edge get exercised too.
+
+// stdlib
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// internal
+#include "narrowphase.hpp"
+
+namespace {
+// the tests as they were before the kernels, see collidesCircle / collidesAABBMot
+bool referenceCircle(const CirclePairs& p, size_t k) {
+    vec2 dp = vec2(p.ax[k], p.ay[k]) - vec2(p.bx[k], p.by[k]);
+    float dist_squared = dot(dp, dp);
+    return dist_squared < std::max(p.a_r_squared[k], p.b_r_squared[k]);
+}
+
+bool referenceBox(const BoxPairs& p, size_t k) {
+    float a_left = p.ax[k] - p.a_half_w[k], a_right = p.ax[k] + p.a_half_w[k];
+    float a_top = p.ay[k] - p.a_half_h[k], a_bottom = p.ay[k] + p.a_half_h[k];
+    float b_left = p.bx[k] - p.b_half_w[k], b_right = p.bx[k] + p.b_half_w[k];
+    float b_top = p.by[k] - p.b_half_h[k], b_bottom = p.by[k] + p.b_half_h[k];
+    return !(a_right < b_left || b_right < a_left || a_bottom < b_top || b_bottom < a_top);
+}
+
+template <typename Pairs, typename Kernel, typename Reference>
+bool check(const char* name, const Pairs& pairs, Kernel kernel, Reference reference) {
+    using clock = std::chrono::high_resolution_clock;
+    std::vector<uint32_t> kernel_hits;
+    std::vector<uint32_t> reference_hits;
+    kernel_hits.reserve(pairs.size());
+    reference_hits.reserve(pairs.size());
+
+    auto t0 = clock::now();
+    kernel(pairs, 0, pairs.size(), kernel_hits);
+    auto t1 = clock::now();
+    for (size_t k = 0; k < pairs.size(); k++) {
+        if (reference(pairs, k)) reference_hits.push_back((uint32_t) k);
+    }
+    auto t2 = clock::now();
+
+    float kernel_ms = std::chrono::duration<float, std::milli>(t1 - t0).count();
+    float reference_ms = std::chrono::duration<float, std::milli>(t2 - t1).count();
+    printf("%-7s %zu pairs, %zu hits, kernel %.3f ms, reference %.3f ms\n",
+           name,
+           pairs.size(),
+           reference_hits.size(),
+           kernel_ms,
+           reference_ms);
+
+    if (kernel_hits == reference_hits) return true;
+    size_t k = 0;
+    while (k < kernel_hits.size() && k < reference_hits.size() && kernel_hits[k] == reference_hits[k]) k++;
+    fprintf(stderr,
+            "%s: hit lists differ at entry %zu (kernel %zu hits, reference %zu hits)\n",
+            name,
+            k,
+            kernel_hits.size(),
+            reference_hits.size());
+    return false;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t pair_count = 100000;
+    unsigned int seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--pairs=", 8) == 0) {
+            pair_count = strtoul(argv[i] + 8, nullptr, 10);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = (unsigned int) strtoul(argv[i] + 7, nullptr, 10);
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-500.f, 500.f);
+    std::uniform_real_distribution<float> extent(1.f, 200.f);
+    std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+
+    CirclePairs circles;
+    BoxPairs boxes;
+    for (size_t k = 0; k < pair_count; k++) {
+        vec2 a = {position(rng), position(rng)};
+        vec2 b = {position(rng), position(rng)};
+        vec2 a_half = {extent(rng), extent(rng)};
+        vec2 b_half = {extent(rng), extent(rng)};
+        float a_r_sq = dot(a_half, a_half);
+        float b_r_sq = dot(b_half, b_half);
+        if (k % 3 == 0) {
+            // on the edge: the centres exactly the larger radius apart, the boxes just touching
+            float r = sqrt(std::max(a_r_sq, b_r_sq));
+            float t = angle(rng);
+            b = a + vec2(cos(t), sin(t)) * r;
+            if (k % 2 == 0) b = {a.x + a_half.x + b_half.x, a.y};
+        }
+        circles.push((uint32_t) k, (uint32_t) k + 1, a, a_r_sq, b, b_r_sq);
+        boxes.push((uint32_t) k, (uint32_t) k + 1, a, a_half, b, b_half);
+    }
+
+    bool ok = check("circles", circles, narrowphaseCircles, referenceCircle);
+    ok = check("boxes", boxes, narrowphaseBoxes, referenceBox) && ok;
+    printf("%s\n", ok ? "ok" : "MISMATCH");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
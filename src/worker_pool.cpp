@@ -0,0 +1,74 @@
+#include "worker_pool.hpp"
+
+#include "alloc_tracking.hpp"
+#include "profiler.hpp"
+
+WorkerPool::WorkerPool(unsigned int worker_count) {
+    for (unsigned int i = 0; i < worker_count; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void WorkerPool::run(size_t task_count, const std::function<void(size_t)>& job) {
+    if (task_count == 0) return;
+    if (workers.empty() || task_count == 1) {
+        for (size_t task = 0; task < task_count; task++) job(task);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_job = &job;
+        current_task_count = task_count;
+        current_allocation_zone = currentAllocationZone();
+        next_task = 0;
+        busy_workers = (unsigned int) workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runTasks();
+
+    // every worker checks in once per batch, so none of them can still be looking at job afterwards
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy_workers == 0; });
+    current_job = nullptr;
+}
+
+void WorkerPool::runTasks() {
+    for (size_t task = next_task++; task < current_task_count; task = next_task++) {
+        (*current_job)(task);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    Profiler::nameThread("worker");
+    uint64_t seen_generation = 0;
+    while (true) {
+        int allocation_zone;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+            allocation_zone = current_allocation_zone;
+        }
+
+        {
+            ScopedAllocationZone zone(allocation_zone);
+            runTasks();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0) done.notify_one();
+    }
+}
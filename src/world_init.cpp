@@ -8,14 +8,11 @@
 #include "tinyECS/components.hpp"
 #include "tinyECS/entity.hpp"
 #include "tinyECS/registry.hpp"
-#include <random>
+#include "rng.hpp"
 #include "saveload_system.hpp"
 
 ENEMY_TYPE getRandEnemyType() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(0, 3);
-    return static_cast<ENEMY_TYPE>(distrib(gen));
+    return static_cast<ENEMY_TYPE>(RngService::getInstance().stream(RNG_STREAM::ENEMY_SPAWNS).nextInt(0, 3));
 }
 
 int getEnemyHealth(ENEMY_TYPE type) {
@@ -378,6 +375,7 @@ Entity createSteeringWheel(vec2 tile_pos) {
 
     motion.scale = {GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX};
 
+    registry.renderLayers.insert(entity, {RENDER_LAYER_MODULES});
     registry.renderRequests.insert(
         entity, {TEXTURE_ASSET_ID::STEERING_WHEEL, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
 
@@ -398,6 +396,7 @@ Entity createCannon(vec2 tile_pos) {
 
     motion.scale = {GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX};
 
+    registry.renderLayers.insert(cannon, {RENDER_LAYER_MODULES});
     registry.renderRequests.insert(
         cannon, {TEXTURE_ASSET_ID::SIMPLE_CANNON01, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
 
@@ -431,6 +430,7 @@ Entity createLaserWeapon(vec2 tile_pos){
 
     motion.scale = {GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX};
 
+    registry.renderLayers.insert(laser, {RENDER_LAYER_MODULES});
     registry.renderRequests.insert(
         laser, {TEXTURE_ASSET_ID::LASER_WEAPON0, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
 
@@ -498,6 +498,7 @@ Entity createHealModule(vec2 tile_pos) {
 
     motion.scale = vec2(GRID_CELL_WIDTH_PX, GRID_CELL_HEIGHT_PX);
 
+    registry.renderLayers.insert(heal, {RENDER_LAYER_MODULES});
     registry.renderRequests.insert(
         heal, {TEXTURE_ASSET_ID::HEAL_MODULE, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
 
@@ -604,6 +605,7 @@ Entity createWaterBackground() {
     waterMotion.scale.x = width;
     waterMotion.scale.y = height;
 
+    registry.renderLayers.insert(waterbg, {RENDER_LAYER_WATER});
     registry.renderRequests.insert(
         waterbg, {TEXTURE_ASSET_ID::WATER_BACKGROUND, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
     return waterbg;
@@ -621,6 +623,7 @@ Entity createIslandBackground(int width, int height, int offset_x, int offset_y,
     islMotion.scale.x = width;
     islMotion.scale.y = height;
 
+    registry.renderLayers.insert(islandbg, {RENDER_LAYER_ISLAND});
     registry.renderRequests.insert(
         islandbg, {island_texture, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
     return islandbg;
@@ -676,7 +679,7 @@ Entity createShip() {
     //     entity, {TEXTURE_ASSET_ID::TEXTURE_COUNT, EFFECT_ASSET_ID::EGG, GEOMETRY_BUFFER_ID::SHIP_SQUARE});
 
     RenderLayer& render_layer = registry.renderLayers.emplace(entity);
-    render_layer.layer = 2;
+    render_layer.layer = RENDER_LAYER_SHIP;
     registry.renderRequests.insert(
         entity, {TEXTURE_ASSET_ID::RAFT, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
 
@@ -720,8 +723,7 @@ Entity createOverlay(float alpha, vec3 color) {
 }
 
 
-std::vector<tson::Vector2i> get_poly_from_motion(const Motion& motion) {
-    std::vector<tson::Vector2i> polygon;
+std::array<tson::Vector2i, 4> get_corners_from_motion(const Motion& motion) {
     int posX = motion.position.x;
     int posY = motion.position.y;
     int rot = motion.angle;  // in degrees
@@ -732,21 +734,26 @@ std::vector<tson::Vector2i> get_poly_from_motion(const Motion& motion) {
     double cosA = std::cos(rad);
     double sinA = std::sin(rad);
 
-    std::vector<tson::Vector2i> corners = {
+    std::array<tson::Vector2i, 4> corners = {{
         {-halfWidth, -halfHeight},  // top left
         {halfWidth, -halfHeight},   // top right
         {halfWidth, halfHeight},    // bottom right
         {-halfWidth, halfHeight}    // bottom left
-    };
+    }};
 
     // rotate and translate back because it rotates around origin
-    for (const auto& corner : corners) {
+    for (auto& corner : corners) {
         int xNew = static_cast<int>(corner.x * cosA + corner.y * sinA) + posX;
         int yNew = static_cast<int>(-corner.x * sinA + corner.y * cosA) + posY;
-        polygon.push_back(tson::Vector2i(xNew, yNew));
+        corner = tson::Vector2i(xNew, yNew);
     }
 
-    return polygon;
+    return corners;
+}
+
+std::vector<tson::Vector2i> get_poly_from_motion(const Motion& motion) {
+    std::array<tson::Vector2i, 4> corners = get_corners_from_motion(motion);
+    return std::vector<tson::Vector2i>(corners.begin(), corners.end());
 }
 
 std::vector<Entity> createBaseProgressLines(Entity base_entity) {
@@ -800,12 +807,9 @@ Entity createFilledTile(vec2 position, vec2 size)
 // TODO: refactor this after map include disasters
 Entity createDisaster(Entity entity) {
     // added to background object in map_init
-    std::random_device dev;
-    std::mt19937 rng(dev());
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0, 1); // int distribution in range [0, 1]
-
-    int random_signX = dist(rng) == 0 ? 1 : -1;
-    int random_signY = dist(rng) == 0 ? 1 : -1;
+    Pcg32& rng = RngService::getInstance().stream(RNG_STREAM::DISASTERS);
+    int random_signX = rng.nextBelow(2) == 0 ? 1 : -1;
+    int random_signY = rng.nextBelow(2) == 0 ? 1 : -1;
 
     Motion& motion = registry.motions.get(entity);
     Disaster& disaster = registry.disasters.get(entity);
@@ -820,7 +824,7 @@ Entity createDisaster(Entity entity) {
             motion.scale = {168, 168};
 
             RenderLayer& render_layer_tornado = registry.renderLayers.emplace(entity);
-            render_layer_tornado.layer = 3;
+            render_layer_tornado.layer = RENDER_LAYER_TORNADO;
             registry.renderRequests.insert(
                 entity, {TEXTURE_ASSET_ID::TORNADO0, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
 
@@ -833,7 +837,7 @@ Entity createDisaster(Entity entity) {
             motion.scale = {168, 112};
 
             RenderLayer& render_layer_wp = registry.renderLayers.emplace(entity);
-            render_layer_wp.layer = 1;
+            render_layer_wp.layer = RENDER_LAYER_WHIRLPOOL;
             registry.renderRequests.insert(
                 entity, {TEXTURE_ASSET_ID::WHIRLPOOL0, EFFECT_ASSET_ID::TEXTURED, GEOMETRY_BUFFER_ID::SPRITE});
         }
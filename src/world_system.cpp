@@ -3,6 +3,8 @@
 #include "GLFW/glfw3.h"
 #include "camera_system.hpp"
 #include "common.hpp"
+#include "frame_stats.hpp"
+#include "perf_hud.hpp"
 #include "sceneManager/scene_manager.hpp"
 #include "tinyECS/components.hpp"
 #include "tinyECS/registry.hpp"
@@ -11,6 +13,7 @@
 
 // stlib
 #include <cassert>
+#include <cstdio>
 #include <glm/ext/vector_float2.hpp>
 #include <iostream>
 #include <ostream>
@@ -19,11 +22,10 @@
 bool WorldSystem::isExitPressed = false;
 // create the world
 WorldSystem::WorldSystem() {
-    // seeding rng with random device
-    rng = std::default_random_engine(std::random_device()());
     fpsCounter = 0;
     window_width_px = WINDOW_WIDTH_PX;
     window_height_px = WINDOW_HEIGHT_PX;
+    register_collision_handlers();
 }
 
 WorldSystem::~WorldSystem() {
@@ -31,7 +33,7 @@ WorldSystem::~WorldSystem() {
     registry.clear_all_components();
 
     // Close the window
-    glfwDestroyWindow(window);
+    if (window != nullptr) glfwDestroyWindow(window);
 }
 
 // Debugging
@@ -43,7 +45,8 @@ void glfw_err_cb(int error, const char* desc) {
 
 // call to close the window, wrapper around GLFW commands
 void WorldSystem::close_window() {
-    glfwSetWindowShouldClose(window, GLFW_TRUE);
+    should_close = true;
+    if (window != nullptr) glfwSetWindowShouldClose(window, GLFW_TRUE);
 }
 
 // World initialization
@@ -90,13 +93,16 @@ GLFWwindow* WorldSystem::create_window() {
     // http://www.glfw.org/docs/latest/input_guide.html
     glfwSetWindowUserPointer(window, this);
     auto key_redirect = [](GLFWwindow* wnd, int _0, int _1, int _2, int _3) {
-        ((WorldSystem*) glfwGetWindowUserPointer(wnd))->on_key(_0, _1, _2, _3);
+        WorldSystem* world = (WorldSystem*) glfwGetWindowUserPointer(wnd);
+        if (world->live_input) world->on_key(_0, _1, _2, _3);
     };
     auto cursor_pos_redirect = [](GLFWwindow* wnd, double _0, double _1) {
-        ((WorldSystem*) glfwGetWindowUserPointer(wnd))->on_mouse_move({_0, _1});
+        WorldSystem* world = (WorldSystem*) glfwGetWindowUserPointer(wnd);
+        if (world->live_input) world->on_mouse_move({_0, _1});
     };
     auto mouse_button_pressed_redirect = [](GLFWwindow* wnd, int _button, int _action, int _mods) {
-        ((WorldSystem*) glfwGetWindowUserPointer(wnd))->on_mouse_button_pressed(_button, _action, _mods);
+        WorldSystem* world = (WorldSystem*) glfwGetWindowUserPointer(wnd);
+        if (world->live_input) world->on_mouse_button_pressed(_button, _action, _mods);
     };
 
     glfwSetKeyCallback(window, key_redirect);
@@ -172,16 +178,16 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
     if(isExitPressed){
         close_window();
     }
-    int current_width, current_height;
-    glfwGetWindowSize(window, &current_width, &current_height);
-    if (current_width != window_width_px || current_height != window_height_px) {
-        window_width_px = current_width;
-        window_height_px = current_height;
-        std::cout << "Window size updated: " << window_width_px << "x" << window_height_px << std::endl;
+    // headless runs keep the design size
+    if (window != nullptr) {
+        int current_width, current_height;
+        glfwGetWindowSize(window, &current_width, &current_height);
+        if (current_width != window_width_px || current_height != window_height_px) {
+            window_width_px = current_width;
+            window_height_px = current_height;
+            std::cout << "Window size updated: " << window_width_px << "x" << window_height_px << std::endl;
+        }
     }
-
-    std::string title = "Bnuuy's Ship      FPS: " + std::to_string(fpsCounter) + "        " + title_points;
-    glfwSetWindowTitle(window, title.c_str());
     assert(registry.screenStates.components.size() <= 1);
     ScreenState& screen = registry.screenStates.components[0];
 
@@ -210,20 +216,14 @@ void WorldSystem::restart_game() {
 
 // Compute collisions between entities
 void WorldSystem::handle_collisions() {
-    ComponentContainer<Collision>& collision_container = registry.collisions;
-    std::vector<Entity> collisions_to_remove;
-
-    for (uint i = 0; i < collision_container.components.size(); i++) {
-        Entity e1 = collision_container.entities[i];
-        Entity e2 = collision_container.components[i].other;
-        if (!registry.motions.has(e1) || !registry.motions.has(e2)) {
-            collisions_to_remove.push_back(e1);
-            collisions_to_remove.push_back(e2);
-            continue;
-        }
+    collision_dispatcher.dispatch();
+}
 
-        // Projectile - Enemy collision
-        if (registry.playerProjectiles.has(e1) && registry.enemies.has(e2)) {
+// Responses for each pair of collision categories, the entities are passed in registration order
+void WorldSystem::register_collision_handlers() {
+    // Projectile - Enemy collision
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::PLAYER_PROJECTILE, COLLISION_CATEGORY::ENEMY, [](Entity e1, Entity e2, const Collision&) {
             PlayerProjectile& projectile = registry.playerProjectiles.get(e1);
             Enemy& enemy = registry.enemies.get(e2);
 
@@ -249,62 +249,29 @@ void WorldSystem::handle_collisions() {
 
             if (enemy.health <= 0) registry.remove_all_components_of(e2);
             registry.remove_all_components_of(e1);
+            return true;
+        });
 
-            //Mix_PlayChannel(-1, projectile_enemy_collision, 0);
-
-        } else if (registry.playerProjectiles.has(e2) && registry.enemies.has(e1)) {
-            PlayerProjectile& projectile = registry.playerProjectiles.get(e2);
-            Enemy& enemy = registry.enemies.get(e1);
-
-            enemy.health -= projectile.damage;
-
-            Entity sound_entity = Entity();
-            Sound& sound = registry.sounds.emplace(sound_entity);
-
-            switch (projectile.mod_type) {
-                case NONE:
-                    sound.sound_type = SOUND_ASSET_ID::PROJECTILE_ENEMY_COLLISION;
-                    sound.volume = 5;
-                    break;
-                case BUBBLE:
-                    sound.sound_type = SOUND_ASSET_ID::BUBBLE;
-                    sound.volume = 30;
-
-                    enemy.is_mod_affected = true;
-                    enemy.mod_effect_duration = MODIFIER_EFFECT_DURATION;
-                    enemy.speed *= BUBBLE_MOD_EFFECT_FACTOR;
-                    break;
-            }
-
-            if (enemy.health <= 0) registry.remove_all_components_of(e1);
-
-            registry.remove_all_components_of(e2);
-            
-        }
-
-        // todo laser: add sound
-        // create laser beam collision with enemy: note one laser beam can have collision with multiple enemies at the same time
-        if (registry.laserBeams.has(e1) && registry.enemies.has(e2)) {
+    // todo laser: add sound
+    // one laser beam can have collision with multiple enemies at the same time
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::LASER_BEAM, COLLISION_CATEGORY::ENEMY, [](Entity e1, Entity e2, const Collision&) {
             LaserBeam& beam = registry.laserBeams.get(e1);
             Enemy& enemy = registry.enemies.get(e2);
 
             enemy.health -= beam.damage;
 
             if (enemy.health <= 0) registry.remove_all_components_of(e2);
-        } else if (registry.laserBeams.has(e2) && registry.enemies.has(e1)) {
-            LaserBeam& beam = registry.laserBeams.get(e2);;
-            Enemy& enemy = registry.enemies.get(e1);
-
-            enemy.health -= beam.damage;
-            if (enemy.health <= 0) registry.remove_all_components_of(e1);
-        } 
-
+            return true;
+        });
 
-        // Projectile - Bunny collision
-        if (registry.playerProjectiles.has(e1) && registry.bunnies.has(e2) && registry.bunnies.get(e2).is_jailed) {
-            PlayerProjectile& projectile = registry.playerProjectiles.get(e1);
+    // Projectile - Bunny collision
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::PLAYER_PROJECTILE, COLLISION_CATEGORY::BUNNY, [](Entity e1, Entity e2, const Collision&) {
             Bunny& bunny = registry.bunnies.get(e2);
+            if (!bunny.is_jailed) return true;
 
+            PlayerProjectile& projectile = registry.playerProjectiles.get(e1);
             bunny.jail_health -= projectile.damage;
 
             if (bunny.jail_health <= 0) {
@@ -318,58 +285,31 @@ void WorldSystem::handle_collisions() {
                 bunny.is_jailed = false;
             }
             registry.remove_all_components_of(e1);
+            return true;
+        });
 
-        } else if (registry.playerProjectiles.has(e2) && registry.bunnies.has(e1) && registry.bunnies.get(e1).is_jailed) {
-            PlayerProjectile& projectile = registry.playerProjectiles.get(e2);
-            Bunny& bunny = registry.bunnies.get(e1);
-
-            bunny.jail_health -= projectile.damage;
-
-            if (bunny.jail_health <= 0) {
-                Entity sound_entity = Entity();
-                Sound& sound = registry.sounds.emplace(sound_entity);
-                sound.sound_type = SOUND_ASSET_ID::PROJECTILE_JAIL_COLLISION;
-                sound.volume = 20;
-                registry.motions.get(e1).scale = {28, 28};
-                registry.renderRequests.get(e1).used_texture = TEXTURE_ASSET_ID::BUNNY_NPC_IDLE_UP0;
-                bunny.is_jailed = false;
-            }
-            registry.remove_all_components_of(e2);
-        }
-
-        // Projectile - Ship collision
-        if (registry.enemyProjectiles.has(e1) && registry.ships.has(e2)) {
+    // Projectile - Ship collision
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::ENEMY_PROJECTILE, COLLISION_CATEGORY::SHIP, [this](Entity e1, Entity e2, const Collision&) {
             EnemyProjectile& projectile = registry.enemyProjectiles.get(e1);
             Ship& ship = registry.ships.get(e2);
             ship.health -= projectile.damage;
             registry.remove_all_components_of(e1);
             if (ship.health <= 0.0f) {
                 handle_player_death();
-                return;
-            }
-            Entity sound_entity = Entity();
-            Sound& sound = registry.sounds.emplace(sound_entity);
-            sound.sound_type = SOUND_ASSET_ID::COW_BULLET;
-            sound.volume = 30;
-        } else if (registry.enemyProjectiles.has(e2) && registry.ships.has(e1)) {
-            EnemyProjectile& projectile = registry.enemyProjectiles.get(e2);
-            Ship& ship = registry.ships.get(e1);
-            ship.health -= projectile.damage;
-            registry.remove_all_components_of(e2);
-            if (ship.health <= 0.0f) {
-                handle_player_death();
-                return;
+                return false;
             }
             Entity sound_entity = Entity();
             Sound& sound = registry.sounds.emplace(sound_entity);
             sound.sound_type = SOUND_ASSET_ID::COW_BULLET;
             sound.volume = 30;
-        }
+            return true;
+        });
 
-        // Enemy - Ship collision
-        if (registry.enemies.has(e1) && registry.ships.has(e2)) {
+    // Enemy - Ship collision
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::ENEMY, COLLISION_CATEGORY::SHIP, [this](Entity e1, Entity e2, const Collision&) {
             registry.ships.get(e2).health -= registry.enemies.get(e1).health;
-            // registry.ships.get(e2).health -= 50;
             registry.remove_all_components_of(e1);
             // Play sound
             Entity sound_entity = Entity();
@@ -378,60 +318,54 @@ void WorldSystem::handle_collisions() {
             sound.volume = 10;
 
             // When Player dies (ship health is <= 0)
-            if(registry.ships.get(e2).health <= 0.0f){
+            if (registry.ships.get(e2).health <= 0.0f) {
                 handle_player_death();
-                return;
+                return false;
             }
-            continue;
-        } else if (registry.enemies.has(e2) && registry.ships.has(e1)) {
-            registry.ships.get(e1).health -= registry.enemies.get(e2).health;
-            // registry.ships.get(e1).health -= 50;
-            registry.remove_all_components_of(e2);
-            // Play sound
+            return true;
+        });
+
+    // Ship - Island collision
+    collision_dispatcher.registerContactHandler(
+        COLLISION_CATEGORY::SHIP, COLLISION_CATEGORY::ISLAND, [](CONTACT_EVENT event, Entity, Entity, const Contact&) {
+            if (event != CONTACT_EVENT::ENTER) return;
             Entity sound_entity = Entity();
             Sound& sound = registry.sounds.emplace(sound_entity);
-            sound.sound_type = SOUND_ASSET_ID::ENEMY_SHIP_COLLISION;
-            sound.volume = 10;
-
-            // When Player dies (ship health is <= 0)
-            if(registry.ships.get(e1).health <= 0.0f){
-                handle_player_death();
-                return;
-            }
-            continue;
-        }
-
-        // Ship - Island collision
-        if ((registry.ships.has(e1) && registry.islands.has(e2)) ||
-            (registry.ships.has(e2) && registry.islands.has(e1))) {
-            collisions_to_remove.push_back(e1);
-            collisions_to_remove.push_back(e2);
-            vec2 normal = registry.collisions.get(e1).normal;
-
-            static float last_collision_sound_time = 0.f;
-            float current_time = (float) glfwGetTime();
-            if (current_time - last_collision_sound_time > 1.35f) {
-                Entity sound_entity = Entity();
-                Sound& sound = registry.sounds.emplace(sound_entity);
-                sound.sound_type = SOUND_ASSET_ID::ISLAND_SHIP_COLLISION;
-                sound.volume = 20;
-
-                last_collision_sound_time = current_time;
+            sound.sound_type = SOUND_ASSET_ID::ISLAND_SHIP_COLLISION;
+            sound.volume = 20;
+        });
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::SHIP, COLLISION_CATEGORY::ISLAND, [](Entity, Entity, const Collision& collision) {
+            CameraSystem::GetInstance()->setToPreviousPosition(collision.normal);
+            return true;
+        });
+
+    // Ship - Base collision: bunnies are dropped off once the ship has stayed in the base long enough.
+    // No exit grace, the drop-off timer must not keep running once the ship has left the base.
+    collision_dispatcher.registerContactHandler(
+        COLLISION_CATEGORY::SHIP,
+        COLLISION_CATEGORY::BASE,
+        [](CONTACT_EVENT event, Entity, Entity e2, const Contact& contact) {
+            if (!registry.base.has(e2)) return;
+            Base& base = registry.base.get(e2);
+            switch (event) {
+                case CONTACT_EVENT::ENTER:
+                    base.ship_in_base = true;
+                    break;
+                case CONTACT_EVENT::STAY:
+                    base.drop_off_timer = contact.duration_ms;
+                    break;
+                case CONTACT_EVENT::EXIT:
+                    base.ship_in_base = false;
+                    base.drop_off_timer = 0;
+                    break;
             }
-            CameraSystem::GetInstance()->setToPreviousPosition(normal);
-        }
-
-        // Ship - Base collision
-        if ((registry.ships.has(e1) && registry.base.has(e2)) ||
-            (registry.ships.has(e2) && registry.base.has(e1))) {
-            collisions_to_remove.push_back(e1);
-            collisions_to_remove.push_back(e2);
-            // just print debug stuff rn, behaviour is handled in different system
-            //std::cout << "island over base" << std::endl;            
-        }
+        },
+        0.f);
 
-        // Disaster - Ship collision
-        if (registry.disasters.has(e1) && registry.ships.has(e2)) {
+    // Disaster - Ship collision
+    collision_dispatcher.registerHandler(
+        COLLISION_CATEGORY::DISASTER, COLLISION_CATEGORY::SHIP, [this](Entity e1, Entity e2, const Collision&) {
             registry.ships.get(e2).health -= registry.disasters.get(e1).damage;
             CameraSystem::GetInstance()->vel /= vec2(3, 3);
             // Play sound
@@ -441,47 +375,43 @@ void WorldSystem::handle_collisions() {
             sound.volume = 10;
 
             // When Player dies (ship health is <= 0)
-            if(registry.ships.get(e2).health <= 0.0f){
+            if (registry.ships.get(e2).health <= 0.0f) {
                 handle_player_death();
-                return;
+                return false;
             }
-            continue;
-        } else if (registry.disasters.has(e2) && registry.ships.has(e1)) {
-            registry.ships.get(e1).health -= registry.disasters.get(e2).damage;
-            CameraSystem::GetInstance()->vel /= vec2(3, 3);
-            // Play sound
-            Entity sound_entity = Entity();
-            Sound& sound = registry.sounds.emplace(sound_entity);
-            sound.sound_type = SOUND_ASSET_ID::ENEMY_SHIP_COLLISION;
-            sound.volume = 10;
-
-            // When Player dies (ship health is <= 0)
-            if(registry.ships.get(e1).health <= 0.0f){
-                handle_player_death();
-                return;
-            }
-            
-            continue;
-        }
-    }
-
-    for (Entity entity : collisions_to_remove) {
-        if (registry.collisions.has(entity)) {
-            registry.collisions.remove(entity);
-        }
-    }
-
-    // Remove all collisions from this simulation step
-    registry.collisions.clear();
+            return true;
+        });
 }
 
 // Should the game be over ?
 bool WorldSystem::is_over() const {
+    if (window == nullptr) return should_close;
     return bool(glfwWindowShouldClose(window));
 }
 
-void WorldSystem::add_to_title(std::string new_title_text) {
-    title_points = new_title_text;
+void WorldSystem::set_title_progress(int bunnies_saved, int bunnies_to_win) {
+    title_bunnies_saved = bunnies_saved;
+    title_bunnies_to_win = bunnies_to_win;
+}
+
+// glfwSetWindowTitle goes through the window system, so it is only called when the text changed
+void WorldSystem::refresh_title() {
+    if (window == nullptr) return;
+    // formatted in place, the levels update the progress every frame
+    char title[96];
+    if (title_bunnies_saved < 0) {
+        snprintf(title, sizeof(title), "Bnuuy's Ship      FPS: %d        ", fpsCounter);
+    } else {
+        snprintf(title,
+                 sizeof(title),
+                 "Bnuuy's Ship      FPS: %d        Total bunny saved: %d/%d",
+                 fpsCounter,
+                 title_bunnies_saved,
+                 title_bunnies_to_win);
+    }
+    if (shown_title == title) return;
+    shown_title = title;
+    glfwSetWindowTitle(window, title);
 }
 
 int WorldSystem::getFPScounter() {
@@ -510,6 +440,16 @@ void WorldSystem::handle_player_death(){
 
 // on key callback
 void WorldSystem::on_key(int key, int, int action, int mod) {
+    if (input_recorder) input_recorder->record({INPUT_EVENT_TYPE::KEY, key, action, mod});
+
+    // debug: performance overlay
+    if (action == GLFW_RELEASE && key == GLFW_KEY_F3) PerfHud::getInstance().toggle();
+    // debug: write the recent frame statistics
+    if (action == GLFW_RELEASE && key == GLFW_KEY_F9) {
+        FrameStats& frame_stats = FrameStats::getInstance();
+        frame_stats.exportFile(frame_stats.getExportPath());
+    }
+
     Scene* scene = SceneManager::getInstance().getCurrentScene();
     if (scene) {
         scene->HandleInput(key, action, mod);
@@ -523,6 +463,8 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 }
 
 void WorldSystem::on_mouse_move(vec2 mouse_position) {
+    if (input_recorder) input_recorder->record({INPUT_EVENT_TYPE::MOUSE_MOVE, 0, 0, 0, mouse_position});
+
     // Scale mouse coordinates based on the actual window size vs. design size
     float scale_x = (float) WINDOW_WIDTH_PX / window_width_px;
     float scale_y = (float) WINDOW_HEIGHT_PX / window_height_px;
@@ -541,6 +483,8 @@ void WorldSystem::on_mouse_move(vec2 mouse_position) {
 }
 
 void WorldSystem::on_mouse_button_pressed(int button, int action, int mods) {
+    if (input_recorder) input_recorder->record({INPUT_EVENT_TYPE::MOUSE_BUTTON, button, action, mods});
+
     // on button press
     Scene* scene = SceneManager::getInstance().getCurrentScene();
     if (scene) {